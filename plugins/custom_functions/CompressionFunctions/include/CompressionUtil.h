@@ -0,0 +1,32 @@
+#ifndef CompressionUtil_h
+#define CompressionUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+/******************************************************************************/
+/* Compressed value layout
+
+   4 byte little-endian uncompressed size | LZ4 block
+
+   The block follows the standard LZ4 block format, so it can be decoded by any
+   LZ4 implementation once the size prefix is stripped. */
+
+#define COMPRESSION_SIZE_PREFIX_LENGTH  4
+
+class CompressionUtil
+{
+public:
+    // largest possible compressed value for an input size, prefix included
+    static size_t compressBound(size_t size);
+    // compress into output (at least compressBound(size) bytes), returns the compressed length
+    static size_t compress(const char* input, size_t size, char* output);
+    // uncompressed size recorded in a compressed value
+    static size_t decompressedSize(const char* input, size_t size);
+    // decompress into output (exactly decompressedSize() bytes); throws on corrupt input
+    static void decompress(const char* input, size_t size, char* output);
+};
+
+#endif /* CompressionUtil_h */
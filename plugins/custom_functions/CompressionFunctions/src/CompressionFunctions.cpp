@@ -0,0 +1,48 @@
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include "dmx_custom_functions.h"
+#include "CompressionUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(Compress, DMX_STRING(compressed), DMX_STRING(input)) {
+
+    if (input.isNull()) {
+        compressed.setNull();
+    }
+    else if (compressed.getOutputCapacity() >= CompressionUtil::compressBound(input.size())) {
+        //LZ4 block straight into the output buffer
+        compressed.setOutputLength(CompressionUtil::compress(input.data(), input.size(), compressed.getOutputData()));
+    }
+    else {
+        //a truncated compressed value cannot be decoded
+        std::vector<char, DmxAllocator<char> > buffer(CompressionUtil::compressBound(input.size()));
+        size_t length = CompressionUtil::compress(input.data(), input.size(), &buffer[0]);
+        if (length > compressed.getOutputCapacity()) {
+            throw std::runtime_error("compressed value exceeds the output buffer");
+        }
+        memcpy(compressed.getOutputData(), &buffer[0], length);
+        compressed.setOutputLength(length);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(Decompress, DMX_STRING(text), DMX_STRING(input)) {
+
+    if (input.isNull()) {
+        text.setNull();
+    }
+    else {
+        //size prefix gives the exact output length
+        size_t length = CompressionUtil::decompressedSize(input.data(), input.size());
+        if (length > text.getOutputCapacity()) {
+            throw std::runtime_error("decompressed value exceeds the output buffer");
+        }
+        CompressionUtil::decompress(input.data(), input.size(), text.getOutputData());
+        text.setOutputLength(length);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
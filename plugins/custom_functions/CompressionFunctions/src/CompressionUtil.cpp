@@ -0,0 +1,380 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <stdexcept>
+#include <stdint.h>
+#include "dmx_custom_functions.h"
+#include "CompressionUtil.h"
+
+/******************************************************************************/
+
+/* LZ4 block format limits */
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5;          // the block ends with at least 5 literals
+static const size_t MATCH_FIND_LIMIT = 12;      // no match starts in the last 12 bytes
+static const size_t MAX_DISTANCE = 65535;
+static const size_t RUN_MASK = 15;
+
+/* Match finder */
+static const unsigned MIN_HASH_LOG = 8;
+static const unsigned MAX_HASH_LOG = 16;
+static const unsigned MAX_CHAIN_ATTEMPTS = 16;
+static const size_t CHAIN_SIZE = 65536;         // one link per position inside the window
+static const size_t GOOD_MATCH_LENGTH = 64;     // stop searching the chain after a match this long
+static const unsigned SKIP_TRIGGER = 6;         // step grows by one every 64 positions without a match
+
+/* Decoder copies this many bytes at once when the buffers have room */
+static const size_t WILD_COPY_LENGTH = 16;
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t read32(const unsigned char* p) {
+//
+//Purpose
+//-------
+// unaligned 4 byte load
+//
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t hashPosition(const unsigned char* p, unsigned hashLog) {
+//
+//Purpose
+//-------
+// multiplicative hash of the 4 bytes at p
+//
+    return (read32(p) * 2654435761U) >> (32 - hashLog);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline size_t matchLength(const unsigned char* p, const unsigned char* match, const unsigned char* limit) {
+//
+//Purpose
+//-------
+// number of equal bytes from p and match, p not passing limit
+//
+    const unsigned char* start = p;
+    while (p + sizeof(uint64_t) <= limit) {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, p, sizeof(a));
+        memcpy(&b, match, sizeof(b));
+        uint64_t diff = a ^ b;
+        if (diff != 0) {
+#if defined(__GNUC__) && (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+            return static_cast<size_t>(p - start) + (__builtin_ctzll(diff) >> 3);
+#else
+            break;
+#endif
+        }
+        p += sizeof(uint64_t);
+        match += sizeof(uint64_t);
+    }
+    while (p < limit && *p == *match) {
+        p++;
+        match++;
+    }
+    return static_cast<size_t>(p - start);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline unsigned char* writeLength(unsigned char* op, size_t length) {
+//
+//Purpose
+//-------
+// length continuation bytes after a saturated token nibble
+//
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static unsigned char* writeSequence(unsigned char* op, const unsigned char* literals, size_t literalLength,
+                                    size_t offset, size_t length) {
+//
+//Purpose
+//-------
+// one LZ4 sequence: token, literals, offset, match length (length 0 for the
+// final literal-only sequence)
+//
+    unsigned char* token = op++;
+    *token = static_cast<unsigned char>((literalLength < RUN_MASK ? literalLength : RUN_MASK) << 4);
+    if (literalLength >= RUN_MASK) {
+        op = writeLength(op, literalLength - RUN_MASK);
+    }
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if (length == 0) {
+        return op;
+    }
+
+    *op++ = static_cast<unsigned char>(offset);
+    *op++ = static_cast<unsigned char>(offset >> 8);
+    size_t matchCode = length - MIN_MATCH;
+    *token |= static_cast<unsigned char>(matchCode < RUN_MASK ? matchCode : RUN_MASK);
+    if (matchCode >= RUN_MASK) {
+        op = writeLength(op, matchCode - RUN_MASK);
+    }
+    return op;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t compressBlock(const unsigned char* input, size_t size, unsigned char* output) {
+//
+//Purpose
+//-------
+// greedy LZ4 block compression; matches are found through hash chains that
+// link every earlier position with the same 4 byte hash inside the window
+//
+    unsigned char* op = output;
+    const unsigned char* anchor = input;
+
+    if (size < MATCH_FIND_LIMIT + 1) {
+        op = writeSequence(op, anchor, size, 0, 0);
+        return static_cast<size_t>(op - output);
+    }
+
+    /* small values get small tables: clearing them is part of every call */
+    unsigned hashLog = MIN_HASH_LOG;
+    while (hashLog < MAX_HASH_LOG && (static_cast<size_t>(1) << hashLog) < size) {
+        hashLog++;
+    }
+    /* on the host memory callbacks, charged to the call */
+    std::vector<uint32_t, DmxAllocator<uint32_t> > head(static_cast<size_t>(1) << hashLog, 0);    // position + 1, 0 if empty
+    std::vector<uint16_t, DmxAllocator<uint16_t> > chain(size < CHAIN_SIZE ? size : CHAIN_SIZE);  // distance to the previous position
+
+    const unsigned char* matchFindEnd = input + size - MATCH_FIND_LIMIT;
+    const unsigned char* matchLimit = input + size - LAST_LITERALS;
+    const unsigned char* ip = input;
+    const unsigned char* inserted = input;      // positions before this are in the chains
+    size_t misses = 0;
+
+    while (ip <= matchFindEnd) {
+        /* link positions up to ip; runs skipped over incompressible data are not linked */
+        if (static_cast<size_t>(ip - inserted) > MAX_CHAIN_ATTEMPTS) {
+            inserted = ip;
+        }
+        for (; inserted <= ip; inserted++) {
+            size_t position = static_cast<size_t>(inserted - input);
+            uint32_t& slot = head[hashPosition(inserted, hashLog)];
+            size_t distance = (slot == 0) ? 0 : position - (slot - 1);
+            chain[position % CHAIN_SIZE] = static_cast<uint16_t>(distance > MAX_DISTANCE ? 0 : distance);
+            slot = static_cast<uint32_t>(position + 1);
+        }
+
+        /* longest candidate along the chain */
+        size_t position = static_cast<size_t>(ip - input);
+        size_t bestLength = 0;
+        size_t bestOffset = 0;
+        size_t distance = chain[position % CHAIN_SIZE];
+        size_t candidate = position;
+        uint32_t current = read32(ip);
+        for (unsigned attempt = 0; attempt < MAX_CHAIN_ATTEMPTS && distance != 0; attempt++) {
+            candidate -= distance;
+            if (position - candidate > MAX_DISTANCE) {
+                break;
+            }
+            const unsigned char* match = input + candidate;
+            if (read32(match) == current) {
+                size_t length = MIN_MATCH + matchLength(ip + MIN_MATCH, match + MIN_MATCH, matchLimit);
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestOffset = position - candidate;
+                    if (length >= GOOD_MATCH_LENGTH) {
+                        break;
+                    }
+                }
+            }
+            distance = chain[candidate % CHAIN_SIZE];
+        }
+
+        if (bestLength < MIN_MATCH) {
+            ip += 1 + (misses++ >> SKIP_TRIGGER);
+            continue;
+        }
+        misses = 0;
+
+        op = writeSequence(op, anchor, static_cast<size_t>(ip - anchor), bestOffset, bestLength);
+        ip += bestLength;
+        anchor = ip;
+    }
+
+    op = writeSequence(op, anchor, static_cast<size_t>(input + size - anchor), 0, 0);
+    return static_cast<size_t>(op - output);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline size_t readLength(const unsigned char*& ip, const unsigned char* inputEnd) {
+//
+//Purpose
+//-------
+// length continuation bytes after a saturated token nibble
+//
+    size_t length = 0;
+    unsigned char byte;
+    do {
+        if (ip >= inputEnd) {
+            throw std::runtime_error("corrupt compressed value: truncated length");
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void decompressBlock(const unsigned char* input, size_t size, unsigned char* output, size_t outputSize) {
+//
+//Purpose
+//-------
+// bounds-checked LZ4 block decoding into a buffer of exactly outputSize bytes
+//
+    const unsigned char* ip = input;
+    const unsigned char* inputEnd = input + size;
+    unsigned char* op = output;
+    unsigned char* outputEnd = output + outputSize;
+
+    for (;;) {
+        if (ip >= inputEnd) {
+            throw std::runtime_error("corrupt compressed value: truncated block");
+        }
+        unsigned token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == RUN_MASK) {
+            literalLength += readLength(ip, inputEnd);
+        }
+        if (literalLength > static_cast<size_t>(inputEnd - ip) || literalLength > static_cast<size_t>(outputEnd - op)) {
+            throw std::runtime_error("corrupt compressed value: literals out of bounds");
+        }
+        if (literalLength <= WILD_COPY_LENGTH && inputEnd - ip >= static_cast<ptrdiff_t>(WILD_COPY_LENGTH)
+            && outputEnd - op >= static_cast<ptrdiff_t>(WILD_COPY_LENGTH)) {
+            /* fixed size copy; bytes past the literals are overwritten later */
+            memcpy(op, ip, WILD_COPY_LENGTH);
+        } else {
+            memcpy(op, ip, literalLength);
+        }
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == inputEnd) {
+            break;
+        }
+
+        if (inputEnd - ip < 2) {
+            throw std::runtime_error("corrupt compressed value: truncated offset");
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - output)) {
+            throw std::runtime_error("corrupt compressed value: invalid match offset");
+        }
+
+        size_t length = token & RUN_MASK;
+        if (length == RUN_MASK) {
+            length += readLength(ip, inputEnd);
+        }
+        length += MIN_MATCH;
+        if (length > static_cast<size_t>(outputEnd - op)) {
+            throw std::runtime_error("corrupt compressed value: match out of bounds");
+        }
+
+        const unsigned char* match = op - offset;
+        if (offset >= sizeof(uint64_t) && outputEnd - op >= static_cast<ptrdiff_t>(length + WILD_COPY_LENGTH)) {
+            /* 8 byte steps stay behind op even when the match overlaps it */
+            unsigned char* end = op + length;
+            do {
+                memcpy(op, match, sizeof(uint64_t));
+                op += sizeof(uint64_t);
+                match += sizeof(uint64_t);
+            } while (op < end);
+            op = end;
+        } else if (offset >= length) {
+            memcpy(op, match, length);
+            op += length;
+        } else {
+            /* overlapping match repeats the last offset bytes */
+            for (size_t i = 0; i < length; i++) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    if (op != outputEnd) {
+        throw std::runtime_error("corrupt compressed value: size mismatch");
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t CompressionUtil::compressBound(size_t size) {
+//
+//Purpose
+//-------
+// worst case: everything stored as literals
+//
+    return COMPRESSION_SIZE_PREFIX_LENGTH + size + size / 255 + 16;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t CompressionUtil::compress(const char* input, size_t size, char* output) {
+//
+//Purpose
+//-------
+// size prefix followed by the LZ4 block
+//
+    if (size > UINT32_MAX) {
+        throw std::invalid_argument("value too large to compress");
+    }
+
+    unsigned char* prefix = reinterpret_cast<unsigned char*>(output);
+    prefix[0] = static_cast<unsigned char>(size);
+    prefix[1] = static_cast<unsigned char>(size >> 8);
+    prefix[2] = static_cast<unsigned char>(size >> 16);
+    prefix[3] = static_cast<unsigned char>(size >> 24);
+
+    return COMPRESSION_SIZE_PREFIX_LENGTH + compressBlock(reinterpret_cast<const unsigned char*>(input), size,
+                                                          prefix + COMPRESSION_SIZE_PREFIX_LENGTH);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t CompressionUtil::decompressedSize(const char* input, size_t size) {
+//
+//Purpose
+//-------
+// read the size prefix
+//
+    if (size < COMPRESSION_SIZE_PREFIX_LENGTH + 1) {
+        throw std::runtime_error("corrupt compressed value: too short");
+    }
+    const unsigned char* prefix = reinterpret_cast<const unsigned char*>(input);
+    return static_cast<size_t>(prefix[0])
+        | (static_cast<size_t>(prefix[1]) << 8)
+        | (static_cast<size_t>(prefix[2]) << 16)
+        | (static_cast<size_t>(prefix[3]) << 24);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void CompressionUtil::decompress(const char* input, size_t size, char* output) {
+//
+//Purpose
+//-------
+// decode the block after the size prefix
+//
+    decompressBlock(reinterpret_cast<const unsigned char*>(input) + COMPRESSION_SIZE_PREFIX_LENGTH,
+                    size - COMPRESSION_SIZE_PREFIX_LENGTH,
+                    reinterpret_cast<unsigned char*>(output),
+                    decompressedSize(input, size));
+}
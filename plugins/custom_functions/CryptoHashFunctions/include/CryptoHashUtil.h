@@ -0,0 +1,86 @@
+#ifndef CryptoHashUtil_h
+#define CryptoHashUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <stdint.h>
+#include "dmx_custom_functions.h"
+/******************************************************************************/
+
+static const size_t SHA256_DIGEST_LENGTH = 32;
+static const size_t SHA1_DIGEST_LENGTH = 20;
+static const size_t SHA_BLOCK_LENGTH = 64;
+
+/* Incremental SHA-256; blocks go to the SHA extensions when the CPU has them */
+class Sha256
+{
+public:
+    Sha256();
+    // continue from a state after blockCount whole blocks (HMAC midstates)
+    Sha256(const uint32_t state[8], uint64_t blockCount);
+
+    void update(const char* data, size_t size);
+    void final(unsigned char digest[SHA256_DIGEST_LENGTH]);
+
+    const uint32_t* state() const { return m_state; }
+
+private:
+    uint32_t m_state[8];
+    unsigned char m_buffer[SHA_BLOCK_LENGTH];
+    size_t m_bufferLength;
+    uint64_t m_length;              // bytes hashed so far
+};
+
+/* Incremental SHA-1 */
+class Sha1
+{
+public:
+    Sha1();
+
+    void update(const char* data, size_t size);
+    void final(unsigned char digest[SHA1_DIGEST_LENGTH]);
+
+private:
+    uint32_t m_state[5];
+    unsigned char m_buffer[SHA_BLOCK_LENGTH];
+    size_t m_bufferLength;
+    uint64_t m_length;
+};
+
+/* HMAC-SHA-256 key schedule: the states after the inner and outer pad blocks;
+   the key and the states are wiped when the schedule is released */
+class HmacSha256Key
+{
+public:
+    explicit HmacSha256Key(const DmxStringValue& key);
+    ~HmacSha256Key();
+
+    const DmxStringValue& key() const { return m_key; }
+    void mac(const char* data, size_t size, unsigned char digest[SHA256_DIGEST_LENGTH]) const;
+
+private:
+    DmxStringValue m_key;
+    uint32_t m_innerState[8];
+    uint32_t m_outerState[8];
+};
+
+class CryptoHashUtil
+{
+public:
+    // lowercase hex digests
+    static DmxStringValue sha256(const DmxStringValue& value);
+    static DmxStringValue sha1(const DmxStringValue& value);
+    static DmxStringValue hmacSha256(const DmxStringValue& value, const DmxStringValue& key);
+    static DmxStringValue hmacSha256(const DmxStringValue& value, const HmacSha256Key& key);
+
+    // key schedule from the per-thread cache, computed on a miss
+    static const HmacSha256Key& hmacKey(const DmxStringValue& key);
+
+    // true if the SHA extension kernels are in use (present and self-tested)
+    static bool isAccelerated();
+};
+
+#endif /* CryptoHashUtil_h */
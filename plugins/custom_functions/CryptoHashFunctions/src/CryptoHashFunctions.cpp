@@ -0,0 +1,58 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "CryptoHashUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(Sha256, DMX_STRING(digest), DMX_STRING(value)) {
+
+    if (value.isNull()) {
+        digest.setNull();
+    }
+    else {
+        // 64 lowercase hex digits
+        digest = CryptoHashUtil::sha256(value);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+/* Prepared state: the key schedule computed once for the whole job */
+class HmacKeyState
+{
+public:
+    explicit HmacKeyState(void* const* argumentPtrs) : m_key(DmxString(argumentPtrs[2])) {}
+
+    const HmacSha256Key& key() const { return m_key; }
+
+private:
+    HmacSha256Key m_key;
+};
+
+DMX_CUSTOM_FUNCTION(HmacSha256, DMX_STRING(digest), DMX_STRING(value), DMX_STRING(key)) {
+
+    if (value.isNull() || key.isNull()) {
+        digest.setNull();
+    }
+    else {
+        // keyed digest, 64 lowercase hex digits
+        const HmacKeyState* statePtr = dmxGetPreparedState<HmacKeyState>();
+        digest = CryptoHashUtil::hmacSha256(value, (statePtr != NULL) ? statePtr->key() : CryptoHashUtil::hmacKey(key));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(HmacSha256, HmacKeyState, DMX_CONSTANT_ARGUMENT(2))
+
+DMX_CUSTOM_FUNCTION(Sha1, DMX_STRING(digest), DMX_STRING(value)) {
+
+    if (value.isNull()) {
+        digest.setNull();
+    }
+    else {
+        // 40 lowercase hex digits
+        digest = CryptoHashUtil::sha1(value);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
@@ -0,0 +1,755 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+#include "CryptoHashUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+/* Key schedules kept per thread */
+static const size_t HMAC_KEY_CACHE_SIZE = 4;
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t SHA256_INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t SHA1_INITIAL_STATE[5] = {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+/* FIPS 180 example messages with their digests, checked before the SHA
+   extension kernels are trusted */
+struct KnownAnswer {
+    const char* message;
+    const char* sha256;
+    const char* sha1;
+};
+
+static const KnownAnswer KNOWN_ANSWERS[] = {
+    { "",
+      "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+      "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+    { "abc",
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+      "a9993e364706816aba3e25717850c26c9cd0d89d" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+    { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+      "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+      "a49b2446a02c645bf419f995b67091253a04a259" }
+};
+
+typedef void (*Sha256BlocksFunction)(uint32_t state[8], const unsigned char* data, size_t blockCount);
+typedef void (*Sha1BlocksFunction)(uint32_t state[5], const unsigned char* data, size_t blockCount);
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t rotateRight(uint32_t value, unsigned count) {
+//
+//Purpose
+//-------
+// 32 bit rotation, 0 < count < 32
+//
+    return (value >> count) | (value << (32 - count));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t loadBigEndian(const unsigned char* bytes) {
+//
+//Purpose
+//-------
+// big endian 32 bit word
+//
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16)
+         | (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void storeBigEndian(const uint32_t* words, size_t count, unsigned char* bytes) {
+//
+//Purpose
+//-------
+// state words as digest bytes
+//
+    for (size_t i = 0; i < count; i++) {
+        bytes[4 * i] = static_cast<unsigned char>(words[i] >> 24);
+        bytes[4 * i + 1] = static_cast<unsigned char>(words[i] >> 16);
+        bytes[4 * i + 2] = static_cast<unsigned char>(words[i] >> 8);
+        bytes[4 * i + 3] = static_cast<unsigned char>(words[i]);
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue toHex(const unsigned char* bytes, size_t size) {
+//
+//Purpose
+//-------
+// lowercase hex digits, as printed by sha256sum
+//
+    static const char digits[] = "0123456789abcdef";
+    DmxStringValue hex(2 * size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        hex[2 * i] = digits[bytes[i] >> 4];
+        hex[2 * i + 1] = digits[bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t padMessage(const unsigned char* message, size_t size, uint64_t length,
+                         unsigned char padded[2 * SHA_BLOCK_LENGTH]) {
+//
+//Purpose
+//-------
+// final blocks of a message: the last size (< 64) bytes, 0x80, zeros and the
+// total bit length; returns the block count (1 or 2)
+//
+    size_t blockCount = (size + 9 <= SHA_BLOCK_LENGTH) ? 1 : 2;
+    size_t paddedLength = blockCount * SHA_BLOCK_LENGTH;
+
+    memcpy(padded, message, size);
+    padded[size] = 0x80;
+    memset(padded + size + 1, 0, paddedLength - size - 1);
+    uint64_t bits = length * 8;
+    for (size_t i = 0; i < 8; i++) {
+        padded[paddedLength - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    return blockCount;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void sha256BlocksPortable(uint32_t state[8], const unsigned char* data, size_t blockCount) {
+//
+//Purpose
+//-------
+// FIPS 180-4 SHA-256 compression with a rolling 16 word schedule
+//
+    for (; blockCount != 0; blockCount--, data += SHA_BLOCK_LENGTH) {
+        uint32_t w[16];
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (size_t t = 0; t < 64; t++) {
+            uint32_t word;
+            if (t < 16) {
+                word = loadBigEndian(data + 4 * t);
+            } else {
+                uint32_t w15 = w[(t - 15) & 15];
+                uint32_t w2 = w[(t - 2) & 15];
+                uint32_t s0 = rotateRight(w15, 7) ^ rotateRight(w15, 18) ^ (w15 >> 3);
+                uint32_t s1 = rotateRight(w2, 17) ^ rotateRight(w2, 19) ^ (w2 >> 10);
+                word = w[t & 15] + s0 + w[(t - 7) & 15] + s1;
+            }
+            w[t & 15] = word;
+
+            uint32_t t1 = h + (rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25))
+                        + ((e & f) ^ (~e & g)) + SHA256_K[t] + word;
+            uint32_t t2 = (rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22))
+                        + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void sha1BlocksPortable(uint32_t state[5], const unsigned char* data, size_t blockCount) {
+//
+//Purpose
+//-------
+// FIPS 180-4 SHA-1 compression with a rolling 16 word schedule
+//
+    for (; blockCount != 0; blockCount--, data += SHA_BLOCK_LENGTH) {
+        uint32_t w[16];
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+        for (size_t t = 0; t < 80; t++) {
+            uint32_t word;
+            if (t < 16) {
+                word = loadBigEndian(data + 4 * t);
+            } else {
+                word = w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15];
+                word = (word << 1) | (word >> 31);
+            }
+            w[t & 15] = word;
+
+            uint32_t f;
+            uint32_t k;
+            if (t < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (t < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (t < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+
+            uint32_t temp = ((a << 5) | (a >> 27)) + f + e + k + word;
+            e = d;
+            d = c;
+            c = (b << 30) | (b >> 2);
+            b = a;
+            a = temp;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_SHA
+static void sha256BlocksShaNi(uint32_t state[8], const unsigned char* data, size_t blockCount) {
+//
+//Purpose
+//-------
+// SHA-256 compression with the SHA extensions: sha256rnds2 runs two rounds on
+// the ABEF/CDGH halves of the state, sha256msg1/msg2 extend the schedule four
+// words at a time
+//
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    /* DCBA, HGFE -> ABEF, CDGH */
+    __m128i low = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i high = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i abef = _mm_alignr_epi8(low, high, 8);
+    __m128i cdgh = _mm_blend_epi16(high, low, 0xF0);
+
+    for (; blockCount != 0; blockCount--, data += SHA_BLOCK_LENGTH) {
+        const __m128i abefSaved = abef;
+        const __m128i cdghSaved = cdgh;
+        __m128i schedule[4];
+
+        for (size_t i = 0; i < 4; i++) {
+            schedule[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byteSwap);
+        }
+
+        /* 16 groups of four rounds; group i uses schedule[i % 4]. Unrolled so
+           the schedule stays in registers */
+#pragma GCC unroll 16
+        for (size_t i = 0; i < 16; i++) {
+            __m128i& current = schedule[i & 3];
+            __m128i message = _mm_add_epi32(current, _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHA256_K + 4 * i)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+            if (i >= 3 && i <= 14) {
+                __m128i& next = schedule[(i + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(current, schedule[(i + 3) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(message, 0x0E));
+            if (i >= 1 && i <= 12) {
+                schedule[(i + 3) & 3] = _mm_sha256msg1_epu32(schedule[(i + 3) & 3], current);
+            }
+        }
+
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    /* ABEF, CDGH -> DCBA, HGFE */
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_SHA
+static inline __m128i sha1Rounds(__m128i abcd, __m128i e, size_t group) {
+//
+//Purpose
+//-------
+// four SHA-1 rounds; the round function changes every five groups
+//
+    switch (group / 5) {
+    case 0:  return _mm_sha1rnds4_epu32(abcd, e, 0);
+    case 1:  return _mm_sha1rnds4_epu32(abcd, e, 1);
+    case 2:  return _mm_sha1rnds4_epu32(abcd, e, 2);
+    default: return _mm_sha1rnds4_epu32(abcd, e, 3);
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_SHA
+static void sha1BlocksShaNi(uint32_t state[5], const unsigned char* data, size_t blockCount) {
+//
+//Purpose
+//-------
+// SHA-1 compression with the SHA extensions: sha1rnds4 runs four rounds,
+// sha1nexte derives E from the previous ABCD, sha1msg1/msg2 extend the
+// schedule
+//
+    const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+    for (; blockCount != 0; blockCount--, data += SHA_BLOCK_LENGTH) {
+        const __m128i abcdSaved = abcd;
+        const __m128i eSaved = e0;
+        __m128i schedule[4];
+        __m128i e1;
+
+        for (size_t i = 0; i < 4; i++) {
+            schedule[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byteSwap);
+        }
+
+        /* 20 groups of four rounds; group g uses schedule[g % 4], E alternates
+           between e0 and e1. Unrolled so the round function is a constant */
+#pragma GCC unroll 20
+        for (size_t g = 0; g < 20; g++) {
+            __m128i& current = schedule[g & 3];
+            if (g == 0) {
+                e0 = _mm_add_epi32(e0, current);
+                e1 = abcd;
+                abcd = sha1Rounds(abcd, e0, g);
+            } else if (g & 1) {
+                e1 = _mm_sha1nexte_epu32(e1, current);
+                e0 = abcd;
+                abcd = sha1Rounds(abcd, e1, g);
+            } else {
+                e0 = _mm_sha1nexte_epu32(e0, current);
+                e1 = abcd;
+                abcd = sha1Rounds(abcd, e0, g);
+            }
+            if (g >= 3 && g <= 18) {
+                schedule[(g + 1) & 3] = _mm_sha1msg2_epu32(schedule[(g + 1) & 3], current);
+            }
+            if (g >= 1 && g <= 16) {
+                schedule[(g + 3) & 3] = _mm_sha1msg1_epu32(schedule[(g + 3) & 3], current);
+            }
+            if (g >= 2 && g <= 17) {
+                schedule[(g + 2) & 3] = _mm_xor_si128(schedule[(g + 2) & 3], current);
+            }
+        }
+
+        /* group 19 left the previous ABCD in e0 */
+        e0 = _mm_sha1nexte_epu32(e0, eSaved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool passesKnownAnswers(Sha256BlocksFunction sha256Blocks, Sha1BlocksFunction sha1Blocks) {
+//
+//Purpose
+//-------
+// run the FIPS 180 examples through a pair of compression functions
+//
+    for (size_t i = 0; i < sizeof(KNOWN_ANSWERS) / sizeof(KNOWN_ANSWERS[0]); i++) {
+        const unsigned char* message = reinterpret_cast<const unsigned char*>(KNOWN_ANSWERS[i].message);
+        size_t size = strlen(KNOWN_ANSWERS[i].message);
+        size_t wholeBlocks = size / SHA_BLOCK_LENGTH;
+        unsigned char padded[2 * SHA_BLOCK_LENGTH];
+        size_t paddedBlocks = padMessage(message + wholeBlocks * SHA_BLOCK_LENGTH, size % SHA_BLOCK_LENGTH, size, padded);
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+
+        uint32_t state256[8];
+        std::copy(SHA256_INITIAL_STATE, SHA256_INITIAL_STATE + 8, state256);
+        sha256Blocks(state256, message, wholeBlocks);
+        sha256Blocks(state256, padded, paddedBlocks);
+        storeBigEndian(state256, 8, digest);
+        if (toHex(digest, SHA256_DIGEST_LENGTH) != KNOWN_ANSWERS[i].sha256) {
+            return false;
+        }
+
+        uint32_t state1[5];
+        std::copy(SHA1_INITIAL_STATE, SHA1_INITIAL_STATE + 5, state1);
+        sha1Blocks(state1, message, wholeBlocks);
+        sha1Blocks(state1, padded, paddedBlocks);
+        storeBigEndian(state1, 5, digest);
+        if (toHex(digest, SHA1_DIGEST_LENGTH) != KNOWN_ANSWERS[i].sha1) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/* Compression functions chosen once per process */
+struct ShaKernels {
+    Sha256BlocksFunction sha256Blocks;
+    Sha1BlocksFunction sha1Blocks;
+    bool isAccelerated;
+
+    ShaKernels()
+    : sha256Blocks(sha256BlocksPortable),
+      sha1Blocks(sha1BlocksPortable),
+      isAccelerated(false)
+    {
+#if defined(DMX_SIMD_X86)
+        if (dmxCpuHasSha() && passesKnownAnswers(sha256BlocksShaNi, sha1BlocksShaNi)) {
+            sha256Blocks = sha256BlocksShaNi;
+            sha1Blocks = sha1BlocksShaNi;
+            isAccelerated = true;
+        }
+#endif
+    }
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static const ShaKernels& shaKernels() {
+//
+//Purpose
+//-------
+// kernels selected on first use
+//
+    static const ShaKernels kernels;
+    return kernels;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+Sha256::Sha256()
+: m_bufferLength(0),
+  m_length(0)
+{
+//
+//Purpose
+//-------
+// start a new message
+//
+    std::copy(SHA256_INITIAL_STATE, SHA256_INITIAL_STATE + 8, m_state);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+Sha256::Sha256(const uint32_t state[8], uint64_t blockCount)
+: m_bufferLength(0),
+  m_length(blockCount * SHA_BLOCK_LENGTH)
+{
+//
+//Purpose
+//-------
+// resume a message from an intermediate state
+//
+    std::copy(state, state + 8, m_state);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void Sha256::update(const char* data, size_t size) {
+//
+//Purpose
+//-------
+// hash whole blocks straight from data, keep the tail
+//
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    Sha256BlocksFunction blocks = shaKernels().sha256Blocks;
+    m_length += size;
+
+    if (m_bufferLength != 0) {
+        size_t count = std::min(size, SHA_BLOCK_LENGTH - m_bufferLength);
+        memcpy(m_buffer + m_bufferLength, bytes, count);
+        m_bufferLength += count;
+        bytes += count;
+        size -= count;
+        if (m_bufferLength < SHA_BLOCK_LENGTH) {
+            return;
+        }
+        blocks(m_state, m_buffer, 1);
+        m_bufferLength = 0;
+    }
+
+    if (size >= SHA_BLOCK_LENGTH) {
+        blocks(m_state, bytes, size / SHA_BLOCK_LENGTH);
+        bytes += size - size % SHA_BLOCK_LENGTH;
+        size %= SHA_BLOCK_LENGTH;
+    }
+    memcpy(m_buffer, bytes, size);
+    m_bufferLength = size;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void Sha256::final(unsigned char digest[SHA256_DIGEST_LENGTH]) {
+//
+//Purpose
+//-------
+// pad, hash the last blocks and write the digest
+//
+    unsigned char padded[2 * SHA_BLOCK_LENGTH];
+    size_t blockCount = padMessage(m_buffer, m_bufferLength, m_length, padded);
+    shaKernels().sha256Blocks(m_state, padded, blockCount);
+    storeBigEndian(m_state, 8, digest);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+Sha1::Sha1()
+: m_bufferLength(0),
+  m_length(0)
+{
+//
+//Purpose
+//-------
+// start a new message
+//
+    std::copy(SHA1_INITIAL_STATE, SHA1_INITIAL_STATE + 5, m_state);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void Sha1::update(const char* data, size_t size) {
+//
+//Purpose
+//-------
+// hash whole blocks straight from data, keep the tail
+//
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    Sha1BlocksFunction blocks = shaKernels().sha1Blocks;
+    m_length += size;
+
+    if (m_bufferLength != 0) {
+        size_t count = std::min(size, SHA_BLOCK_LENGTH - m_bufferLength);
+        memcpy(m_buffer + m_bufferLength, bytes, count);
+        m_bufferLength += count;
+        bytes += count;
+        size -= count;
+        if (m_bufferLength < SHA_BLOCK_LENGTH) {
+            return;
+        }
+        blocks(m_state, m_buffer, 1);
+        m_bufferLength = 0;
+    }
+
+    if (size >= SHA_BLOCK_LENGTH) {
+        blocks(m_state, bytes, size / SHA_BLOCK_LENGTH);
+        bytes += size - size % SHA_BLOCK_LENGTH;
+        size %= SHA_BLOCK_LENGTH;
+    }
+    memcpy(m_buffer, bytes, size);
+    m_bufferLength = size;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void Sha1::final(unsigned char digest[SHA1_DIGEST_LENGTH]) {
+//
+//Purpose
+//-------
+// pad, hash the last blocks and write the digest
+//
+    unsigned char padded[2 * SHA_BLOCK_LENGTH];
+    size_t blockCount = padMessage(m_buffer, m_bufferLength, m_length, padded);
+    shaKernels().sha1Blocks(m_state, padded, blockCount);
+    storeBigEndian(m_state, 5, digest);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void wipe(void* dataPtr, size_t size) {
+//
+//Purpose
+//-------
+// overwrite key material; the volatile stores are not removed as dead
+//
+    volatile unsigned char* bytes = static_cast<volatile unsigned char*>(dataPtr);
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = 0;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+HmacSha256Key::HmacSha256Key(const DmxStringValue& key)
+: m_key(key)
+{
+//
+//Purpose
+//-------
+// RFC 2104 key schedule: hash the key if longer than a block, then keep the
+// states after one block of key ^ ipad and of key ^ opad
+//
+    unsigned char block[SHA_BLOCK_LENGTH];
+    memset(block, 0, SHA_BLOCK_LENGTH);
+    if (key.size() > SHA_BLOCK_LENGTH) {
+        Sha256 keyHash;
+        keyHash.update(key.data(), key.size());
+        keyHash.final(block);
+    } else {
+        memcpy(block, key.data(), key.size());
+    }
+
+    char pad[SHA_BLOCK_LENGTH];
+    for (size_t i = 0; i < SHA_BLOCK_LENGTH; i++) {
+        pad[i] = static_cast<char>(block[i] ^ 0x36);
+    }
+    Sha256 inner;
+    inner.update(pad, SHA_BLOCK_LENGTH);
+    std::copy(inner.state(), inner.state() + 8, m_innerState);
+
+    for (size_t i = 0; i < SHA_BLOCK_LENGTH; i++) {
+        pad[i] = static_cast<char>(block[i] ^ 0x5c);
+    }
+    Sha256 outer;
+    outer.update(pad, SHA_BLOCK_LENGTH);
+    std::copy(outer.state(), outer.state() + 8, m_outerState);
+
+    wipe(block, sizeof(block));
+    wipe(pad, sizeof(pad));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+HmacSha256Key::~HmacSha256Key() {
+//
+//Purpose
+//-------
+// wipe the key and the pad states before the memory is released
+//
+    if (!m_key.empty()) {
+        wipe(&m_key[0], m_key.size());
+    }
+    wipe(m_innerState, sizeof(m_innerState));
+    wipe(m_outerState, sizeof(m_outerState));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void HmacSha256Key::mac(const char* data, size_t size, unsigned char digest[SHA256_DIGEST_LENGTH]) const {
+//
+//Purpose
+//-------
+// H(key ^ opad || H(key ^ ipad || data)) from the precomputed pad states
+//
+    unsigned char innerDigest[SHA256_DIGEST_LENGTH];
+    Sha256 inner(m_innerState, 1);
+    inner.update(data, size);
+    inner.final(innerDigest);
+
+    Sha256 outer(m_outerState, 1);
+    outer.update(reinterpret_cast<const char*>(innerDigest), SHA256_DIGEST_LENGTH);
+    outer.final(digest);
+}
+
+/******************************************************************************/
+
+/* Most recently used key schedules of the calling thread, on the host memory callbacks */
+struct HmacKeyCache {
+    HmacSha256Key* keys[HMAC_KEY_CACHE_SIZE];
+    size_t next;
+
+    HmacKeyCache() : next(0) {
+        std::fill(keys, keys + HMAC_KEY_CACHE_SIZE, static_cast<HmacSha256Key*>(NULL));
+    }
+    ~HmacKeyCache() {
+        for (size_t i = 0; i < HMAC_KEY_CACHE_SIZE; i++) {
+            dmxDestroy(keys[i]);
+        }
+    }
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+const HmacSha256Key& CryptoHashUtil::hmacKey(const DmxStringValue &key) {
+//
+//Purpose
+//-------
+// key schedule from the per-thread cache, computed on a miss
+//
+    static thread_local HmacKeyCache cache;
+
+    for (size_t i = 0; i < HMAC_KEY_CACHE_SIZE; i++) {
+        if (cache.keys[i] != NULL && cache.keys[i]->key() == key) {
+            return *cache.keys[i];
+        }
+    }
+
+    HmacSha256Key* created = dmxCreate<HmacSha256Key>(key);
+    dmxDestroy(cache.keys[cache.next]);
+    cache.keys[cache.next] = created;
+    cache.next = (cache.next + 1) % HMAC_KEY_CACHE_SIZE;
+    return *created;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue CryptoHashUtil::sha256(const DmxStringValue &value) {
+//
+//Purpose
+//-------
+// SHA-256 digest in hex
+//
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    Sha256 hash;
+    hash.update(value.data(), value.size());
+    hash.final(digest);
+    return toHex(digest, SHA256_DIGEST_LENGTH);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue CryptoHashUtil::sha1(const DmxStringValue &value) {
+//
+//Purpose
+//-------
+// SHA-1 digest in hex
+//
+    unsigned char digest[SHA1_DIGEST_LENGTH];
+    Sha1 hash;
+    hash.update(value.data(), value.size());
+    hash.final(digest);
+    return toHex(digest, SHA1_DIGEST_LENGTH);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue CryptoHashUtil::hmacSha256(const DmxStringValue &value, const DmxStringValue &key) {
+//
+//Purpose
+//-------
+// HMAC-SHA-256 in hex
+//
+    return hmacSha256(value, hmacKey(key));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue CryptoHashUtil::hmacSha256(const DmxStringValue &value, const HmacSha256Key &key) {
+//
+//Purpose
+//-------
+// HMAC-SHA-256 in hex with a precomputed key schedule
+//
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    key.mac(value.data(), value.size(), digest);
+    return toHex(digest, SHA256_DIGEST_LENGTH);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool CryptoHashUtil::isAccelerated() {
+//
+//Purpose
+//-------
+// SHA extension kernels selected
+//
+    return shaKernels().isAccelerated;
+}
@@ -0,0 +1,61 @@
+#ifndef DelimitedUtil_h
+#define DelimitedUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include "dmx_custom_functions.h"
+/******************************************************************************/
+
+typedef std::vector<size_t, DmxAllocator<size_t> > FieldPositions;
+
+/* Field offsets of one record for one delimiter. Field i spans
+   [m_starts[i], m_starts[i + 1] - delimiter length); quoted (CSV) fields keep
+   their quotes until extracted. */
+class FieldIndex
+{
+public:
+    FieldIndex();
+
+    // index record, a copy of the host buffer sourcePtr
+    void build(const DmxStringValue& record, const char* sourcePtr, const DmxStringValue& delimiter, bool isQuoted);
+
+    // true if the index was built for this record and delimiter
+    bool matches(const DmxStringValue& record, const char* sourcePtr, const DmxStringValue& delimiter, bool isQuoted) const;
+
+    size_t fieldCount() const { return m_starts.size() - 1; }
+    // field index (0-based), unquoted for CSV records
+    DmxStringValue field(size_t index) const;
+
+private:
+    DmxStringValue m_record;
+    const char* m_sourcePtr;
+    DmxStringValue m_delimiter;
+    bool m_isQuoted;
+    FieldPositions m_starts;   // field starts, then the end of the record plus the delimiter length
+};
+
+class DelimitedUtil
+{
+public:
+    // field index of the record, reused per thread while the same record is split again
+    static const FieldIndex& fieldIndex(const DmxStringValue& record, const char* sourcePtr,
+                                        const DmxStringValue& delimiter, bool isQuoted);
+
+    // 1-based field position of the record, empty if out of range
+    static DmxStringValue splitPart(const DmxStringValue& record, const char* sourcePtr,
+                                 const DmxStringValue& delimiter, long long position, bool isQuoted);
+    // number of fields, 1 for a record without delimiters
+    static long long fieldCount(const DmxStringValue& record, const char* sourcePtr,
+                                const DmxStringValue& delimiter, bool isQuoted);
+
+    // positions of the delimiters, left to right without overlap; delimiters
+    // between double quotes are skipped if isQuoted
+    static void findDelimiters(const char* record, size_t length, const DmxStringValue& delimiter,
+                               bool isQuoted, FieldPositions& positions);
+};
+
+#endif /* DelimitedUtil_h */
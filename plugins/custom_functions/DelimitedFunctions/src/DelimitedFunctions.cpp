@@ -0,0 +1,56 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "DelimitedUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(SplitPart, DMX_STRING(part), DMX_STRING(record), DMX_STRING(delimiter), DMX_INT(position)) {
+
+    if (record.isNull() || delimiter.isNull() || position.isNull()) {
+        part.setNull();
+    }
+    else {
+        // 1-based field, empty if out of range
+        part = DelimitedUtil::splitPart(record, record.getInputData(), delimiter, position, false);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(FieldCount, DMX_INT(count), DMX_STRING(record), DMX_STRING(delimiter)) {
+
+    if (record.isNull() || delimiter.isNull()) {
+        count.setNull();
+    }
+    else {
+        // delimiters plus one
+        count = DelimitedUtil::fieldCount(record, record.getInputData(), delimiter, false);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(CsvSplitPart, DMX_STRING(part), DMX_STRING(record), DMX_STRING(delimiter), DMX_INT(position)) {
+
+    if (record.isNull() || delimiter.isNull() || position.isNull()) {
+        part.setNull();
+    }
+    else {
+        // 1-based field with quotes removed, empty if out of range
+        part = DelimitedUtil::splitPart(record, record.getInputData(), delimiter, position, true);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(CsvFieldCount, DMX_INT(count), DMX_STRING(record), DMX_STRING(delimiter)) {
+
+    if (record.isNull() || delimiter.isNull()) {
+        count.setNull();
+    }
+    else {
+        // fields, delimiters between quotes excluded
+        count = DelimitedUtil::fieldCount(record, record.getInputData(), delimiter, true);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
@@ -0,0 +1,303 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include "DelimitedUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+static const size_t BLOCK_SIZE = 64;
+
+/* Delimiter and quote positions of one block, one bit per byte */
+struct BlockMasks {
+    uint64_t delimiter;
+    uint64_t quote;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static void classifyScalar(const unsigned char* block, unsigned char delimiter, BlockMasks& masks) {
+//
+//Purpose
+//-------
+// delimiter and quote bits one byte at a time
+//
+    masks.delimiter = 0;
+    masks.quote = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        uint64_t bit = static_cast<uint64_t>(1) << i;
+        if (block[i] == delimiter) {
+            masks.delimiter |= bit;
+        } else if (block[i] == '"') {
+            masks.quote |= bit;
+        }
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static inline uint64_t matchAvx2(__m256i low, __m256i high, char c) {
+//
+//Purpose
+//-------
+// bit mask of the bytes equal to c in a 64 byte block
+//
+    const __m256i value = _mm256_set1_epi8(c);
+    uint64_t lowMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, value)));
+    uint64_t highMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, value)));
+    return lowMask | (highMask << 32);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static void classifyAvx2(const unsigned char* block, unsigned char delimiter, BlockMasks& masks) {
+//
+//Purpose
+//-------
+// delimiter and quote bits with 32 byte compares
+//
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+    masks.delimiter = matchAvx2(low, high, static_cast<char>(delimiter));
+    masks.quote = matchAvx2(low, high, '"');
+}
+#endif
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t prefixXor(uint64_t bits) {
+//
+//Purpose
+//-------
+// bit i is the xor of bits 0..i: 1 between an opening and a closing quote
+//
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline unsigned lowestBit(uint64_t bits) {
+//
+//Purpose
+//-------
+// index of the lowest set bit, bits is not 0
+//
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    unsigned index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void DelimitedUtil::findDelimiters(const char* record, size_t length, const DmxStringValue& delimiter,
+                                   bool isQuoted, FieldPositions& positions) {
+//
+//Purpose
+//-------
+// append the delimiter positions: candidates from the first delimiter byte,
+// 64 bytes at a time, minus those inside quotes; longer delimiters are
+// confirmed with memcmp
+//
+    if (delimiter.empty()) {
+        return;
+    }
+
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(record);
+    const unsigned char first = static_cast<unsigned char>(delimiter[0]);
+    const size_t delimiterLength = delimiter.size();
+    size_t nextAllowed = 0;
+    uint64_t isInQuotes = 0;            // all ones if the previous block ended inside quotes
+#if defined(DMX_SIMD_X86)
+    const bool isAvx2 = dmxCpuHasAvx2();
+#endif
+
+    for (size_t blockStart = 0; blockStart < length; blockStart += BLOCK_SIZE) {
+        const unsigned char* block = text + blockStart;
+        uint64_t valid = ~static_cast<uint64_t>(0);
+        unsigned char padded[BLOCK_SIZE];
+        if (length - blockStart < BLOCK_SIZE) {
+            memset(padded, 0, BLOCK_SIZE);
+            memcpy(padded, block, length - blockStart);
+            block = padded;
+            valid = (static_cast<uint64_t>(1) << (length - blockStart)) - 1;
+        }
+
+        BlockMasks masks;
+#if defined(DMX_SIMD_X86)
+        if (isAvx2) {
+            classifyAvx2(block, first, masks);
+        } else {
+            classifyScalar(block, first, masks);
+        }
+#else
+        classifyScalar(block, first, masks);
+#endif
+
+        uint64_t candidates = masks.delimiter & valid;
+        if (isQuoted) {
+            uint64_t inQuotes = prefixXor(masks.quote & valid) ^ isInQuotes;
+            isInQuotes = static_cast<uint64_t>(static_cast<int64_t>(inQuotes) >> 63);
+            candidates &= ~inQuotes;
+        }
+
+        while (candidates != 0) {
+            size_t position = blockStart + lowestBit(candidates);
+            candidates &= candidates - 1;
+            if (position < nextAllowed) {
+                continue;
+            }
+            if (delimiterLength > 1 && (length - position < delimiterLength
+                                        || memcmp(record + position, delimiter.data(), delimiterLength) != 0)) {
+                continue;
+            }
+            positions.push_back(position);
+            nextAllowed = position + delimiterLength;
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+FieldIndex::FieldIndex()
+: m_sourcePtr(NULL),
+  m_isQuoted(false)
+{
+//
+//Purpose
+//-------
+// empty index, matches no record
+//
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void FieldIndex::build(const DmxStringValue& record, const char* sourcePtr, const DmxStringValue& delimiter, bool isQuoted) {
+//
+//Purpose
+//-------
+// index the fields of a record; buffers are reused from the previous record
+//
+    if (isQuoted && (delimiter.size() != 1 || delimiter[0] == '"')) {
+        throw std::invalid_argument("CSV delimiter must be a single character other than '\"'");
+    }
+
+    m_record = record;
+    m_sourcePtr = sourcePtr;
+    m_delimiter = delimiter;
+    m_isQuoted = isQuoted;
+
+    m_starts.clear();
+    m_starts.push_back(0);
+    DelimitedUtil::findDelimiters(m_record.data(), m_record.size(), m_delimiter, m_isQuoted, m_starts);
+    for (size_t i = 1; i < m_starts.size(); i++) {
+        m_starts[i] += m_delimiter.size();
+    }
+    m_starts.push_back(m_record.size() + m_delimiter.size());
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool FieldIndex::matches(const DmxStringValue& record, const char* sourcePtr, const DmxStringValue& delimiter, bool isQuoted) const {
+//
+//Purpose
+//-------
+// same host buffer, same contents and same delimiter; the contents are
+// compared since the host reuses its buffers for later records
+//
+    return !m_starts.empty()
+        && sourcePtr == m_sourcePtr
+        && isQuoted == m_isQuoted
+        && record.size() == m_record.size()
+        && delimiter == m_delimiter
+        && memcmp(record.data(), m_record.data(), record.size()) == 0;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue FieldIndex::field(size_t index) const {
+//
+//Purpose
+//-------
+// text of a field; for CSV every double quote toggles quoting and "" inside
+// quotes stands for one quote
+//
+    size_t begin = m_starts[index];
+    size_t end = m_starts[index + 1] - m_delimiter.size();
+
+    if (!m_isQuoted || memchr(m_record.data() + begin, '"', end - begin) == NULL) {
+        return m_record.substr(begin, end - begin);
+    }
+
+    DmxStringValue text;
+    text.reserve(end - begin);
+    bool isInQuotes = false;
+    for (size_t i = begin; i < end; i++) {
+        char c = m_record[i];
+        if (c != '"') {
+            text += c;
+        } else if (isInQuotes && i + 1 < end && m_record[i + 1] == '"') {
+            text += '"';
+            i++;
+        } else {
+            isInQuotes = !isInQuotes;
+        }
+    }
+    return text;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+const FieldIndex& DelimitedUtil::fieldIndex(const DmxStringValue& record, const char* sourcePtr,
+                                            const DmxStringValue& delimiter, bool isQuoted) {
+//
+//Purpose
+//-------
+// field index from the per-thread cache, rebuilt when the record changes
+//
+    static thread_local FieldIndex index;
+
+    if (!index.matches(record, sourcePtr, delimiter, isQuoted)) {
+        index.build(record, sourcePtr, delimiter, isQuoted);
+    }
+    return index;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue DelimitedUtil::splitPart(const DmxStringValue& record, const char* sourcePtr,
+                                     const DmxStringValue& delimiter, long long position, bool isQuoted) {
+//
+//Purpose
+//-------
+// 1-based field of the record, empty if out of range
+//
+    const FieldIndex& index = fieldIndex(record, sourcePtr, delimiter, isQuoted);
+
+    if (position < 1 || static_cast<unsigned long long>(position) > index.fieldCount()) {
+        return DmxStringValue();
+    }
+    return index.field(static_cast<size_t>(position - 1));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long DelimitedUtil::fieldCount(const DmxStringValue& record, const char* sourcePtr,
+                                    const DmxStringValue& delimiter, bool isQuoted) {
+//
+//Purpose
+//-------
+// number of fields of the record
+//
+    return static_cast<long long>(fieldIndex(record, sourcePtr, delimiter, isQuoted).fieldCount());
+}
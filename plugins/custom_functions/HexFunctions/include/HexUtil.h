@@ -6,6 +6,7 @@
 
  *******************************************************************************/
 #include <string>
+#include "dmx_custom_functions.h"
 /******************************************************************************/
 /* Custom function return statuses */
 
@@ -13,10 +14,16 @@ class HexUtil
 {
 public:
     // Convert a hex string to an ascii text string
-    static std::string hexToText(const std::string& hexValue);
+    static DmxStringValue hexToText(const DmxStringValue& hexValue);
 
     // Convert a given text to hex string
-    static std::string textToHex(const std::string& text);
+    static DmxStringValue textToHex(const DmxStringValue& text);
+
+    // Convert size / 2 hex digit pairs into text
+    static void hexToText(const char* hexValue, size_t size, char* text);
+
+    // Convert size bytes of text into 2 * size hex digits
+    static void textToHex(const char* text, size_t size, char* hexValue);
 };
 
 #endif /* HexUtil_h */
@@ -29,3 +29,65 @@ DMX_CUSTOM_FUNCTION(TextToHex, DMX_STRING(text), DMX_STRING(input)) {
     return DMX_CUSTOM_FUNCTION_SUCCESS;
 }
 
+
+/* Streaming TextToHex: every input byte becomes two hex digits */
+class TextToHexStream : public DmxStreamFunction
+{
+public:
+    void processChunk(const char* dataPtr, size_t size, DmxStreamWriter& writer) {
+        while (size != 0) {
+            size_t count = writer.reserve(2) / 2;
+            count = (count < size) ? count : size;
+            HexUtil::textToHex(dataPtr, count, writer.getData());
+            writer.commit(2 * count);
+            dataPtr += count;
+            size -= count;
+        }
+    }
+};
+
+DMX_CUSTOM_STREAM_FUNCTION(TextToHex, TextToHexStream, DMX_STREAM_FORWARD)
+
+/* Streaming HexToText: a digit pair may straddle two chunks */
+class HexToTextStream : public DmxStreamFunction
+{
+public:
+    HexToTextStream() : m_hasPendingDigit(false) {}
+
+    void processChunk(const char* dataPtr, size_t size, DmxStreamWriter& writer) {
+        if (m_hasPendingDigit && size != 0) {
+            char pair[2] = { m_pendingDigit, *dataPtr };
+            writer.reserve(1);
+            HexUtil::hexToText(pair, 2, writer.getData());
+            writer.commit(1);
+            m_hasPendingDigit = false;
+            dataPtr++;
+            size--;
+        }
+        while (size >= 2) {
+            size_t count = writer.reserve(1);
+            count = (count < size / 2) ? count : size / 2;
+            HexUtil::hexToText(dataPtr, 2 * count, writer.getData());
+            writer.commit(count);
+            dataPtr += 2 * count;
+            size -= 2 * count;
+        }
+        if (size != 0) {
+            m_pendingDigit = *dataPtr;
+            m_hasPendingDigit = true;
+        }
+    }
+
+    void finish(DmxStreamWriter& writer) {
+        //odd digit count: same trailing blank as HexToText
+        if (m_hasPendingDigit) {
+            writer.write(" ", 1);
+        }
+    }
+
+private:
+    char m_pendingDigit;
+    bool m_hasPendingDigit;
+};
+
+DMX_CUSTOM_STREAM_FUNCTION(HexToText, HexToTextStream, DMX_STREAM_FORWARD)
@@ -5,31 +5,55 @@
  *******************************************************************************/
 #include <string>
 #include <cctype>
+#include <algorithm>
+#include "dmx_custom_functions.h"
 #include "HexUtil.h"
 
 /******************************************************************************/
 
-std::string HexUtil::hexToText(const std::string &hexValue) {
+/* Bytes converted between two polls of the cancel token */
+static const size_t POLL_BLOCK_SIZE = 65536;
 
-    std::string text  = std::string((hexValue.size() + 1) >> 1, ' ');
-    size_t final_text_length = hexValue.size() / 2;
-
-    for (size_t i = 0, j = 0; i < final_text_length; i++, j = j + 2) {
-        text[i] = (((hexValue[j] % 32 + 9) % 25) * 16) + (((hexValue[j+1] % 32) + 9) % 25);
-    }
+DmxStringValue HexUtil::hexToText(const DmxStringValue &hexValue) {
 
+    DmxStringValue text  = DmxStringValue((hexValue.size() + 1) >> 1, ' ');
+    hexToText(hexValue.data(), hexValue.size(), &text[0]);
     return text;
 }
 
-std::string HexUtil::textToHex(const std::string &text) {
+void HexUtil::hexToText(const char* hexValue, size_t size, char* text) {
 
-    std::string hexValue = std::string(text.size() << 1, ' ');
-    char hexMap[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+    size_t final_text_length = size / 2;
+    DmxStopPoller poller(POLL_BLOCK_SIZE);
 
-    for (size_t i = 0; i < text.size(); i++) {
-        hexValue[2 * i] =  hexMap[(text[i] & 0xF0) >> 4];
-        hexValue[2 * i + 1] = hexMap[text[i] & 0x0F];
+    for (size_t blockStart = 0; blockStart < final_text_length; blockStart += POLL_BLOCK_SIZE) {
+        size_t blockEnd = std::min(final_text_length, blockStart + POLL_BLOCK_SIZE);
+        for (size_t i = blockStart, j = 2 * blockStart; i < blockEnd; i++, j = j + 2) {
+            text[i] = (((hexValue[j] % 32 + 9) % 25) * 16) + (((hexValue[j+1] % 32) + 9) % 25);
+        }
+        poller.tick(static_cast<long long>(blockEnd - blockStart));
     }
+}
 
+DmxStringValue HexUtil::textToHex(const DmxStringValue &text) {
+
+    DmxStringValue hexValue = DmxStringValue(text.size() << 1, ' ');
+    textToHex(text.data(), text.size(), &hexValue[0]);
     return hexValue;
 }
+
+void HexUtil::textToHex(const char* text, size_t size, char* hexValue) {
+
+    static const char hexMap[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+    DmxStopPoller poller(POLL_BLOCK_SIZE);
+
+    for (size_t blockStart = 0; blockStart < size; blockStart += POLL_BLOCK_SIZE) {
+        size_t blockEnd = std::min(size, blockStart + POLL_BLOCK_SIZE);
+        for (size_t i = blockStart; i < blockEnd; i++) {
+            hexValue[2 * i] =  hexMap[(text[i] & 0xF0) >> 4];
+            hexValue[2 * i + 1] = hexMap[text[i] & 0x0F];
+        }
+        poller.tick(static_cast<long long>(blockEnd - blockStart));
+    }
+}
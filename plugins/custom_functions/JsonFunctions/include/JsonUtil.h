@@ -0,0 +1,93 @@
+#ifndef JsonUtil_h
+#define JsonUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "dmx_custom_functions.h"
+/******************************************************************************/
+
+/* One step of a compiled path: an object member or an array element */
+struct JsonPathStep
+{
+    DmxStringValue m_key;
+    size_t m_index;
+    bool m_isIndex;
+};
+
+typedef std::vector<JsonPathStep, DmxAllocator<JsonPathStep> > JsonPathSteps;
+
+class JsonPath
+{
+public:
+    // compile $.key, $['key'], $[index] steps; throws on a malformed expression
+    explicit JsonPath(const DmxStringValue& expression);
+
+    const DmxStringValue& expression() const { return m_expression; }
+    const JsonPathSteps& steps() const { return m_steps; }
+
+private:
+    DmxStringValue m_expression;
+    JsonPathSteps m_steps;
+};
+
+/* Lazy structural index: positions of { } [ ] : , outside strings, computed
+   64 bytes at a time only as far as the caller reads */
+class JsonScanner
+{
+public:
+    JsonScanner(const char* json, size_t size);
+
+    // position of the next structural character, std::string::npos at the end
+    size_t next();
+
+private:
+    void indexBlock();
+
+    const char* m_json;
+    size_t m_size;
+    size_t m_blockStart;            // start of the block m_structurals belongs to
+    size_t m_nextBlock;
+    uint64_t m_structurals;         // unread structural positions of the block
+    uint64_t m_isInString;          // all ones if the previous block ended inside a string
+    uint64_t m_isEscaped;           // 1 if the previous block ended with an escaping backslash
+};
+
+class JsonUtil
+{
+public:
+    // kind of value found at a path
+    enum ValueType {
+        JSON_MISSING,
+        JSON_NULL,
+        JSON_STRING,
+        JSON_LITERAL,               // number, true or false
+        JSON_OBJECT,
+        JSON_ARRAY
+    };
+
+    // compiled path from the per-thread cache, compiled on a miss
+    static const JsonPath& compiledPath(const DmxStringValue& path);
+
+    // locate the value at path; [begin, end) is its JSON text
+    static ValueType find(const DmxStringValue& json, const JsonPath& path, size_t& begin, size_t& end);
+
+    // value at path: unescaped for strings, JSON text otherwise; false if missing or null
+    static bool extract(const DmxStringValue& json, const JsonPath& path, DmxStringValue& value);
+    static bool extract(const DmxStringValue& json, const DmxStringValue& path, DmxStringValue& value);
+    // true if path resolves to a well formed value, even null; agrees with extract
+    static bool exists(const DmxStringValue& json, const JsonPath& path);
+    static bool exists(const DmxStringValue& json, const DmxStringValue& path);
+    // element count of the array at path, -1 if there is no array there
+    static long long arrayLength(const DmxStringValue& json, const JsonPath& path);
+    static long long arrayLength(const DmxStringValue& json, const DmxStringValue& path);
+
+    // decode the escapes of a JSON string body
+    static DmxStringValue unescape(const char* text, size_t length);
+};
+
+#endif /* JsonUtil_h */
@@ -0,0 +1,77 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "JsonUtil.h"
+
+
+/* Prepared state: the path compiled once for the whole job */
+class JsonPathState
+{
+public:
+    explicit JsonPathState(void* const* argumentPtrs) : m_path(DmxString(argumentPtrs[2])) {}
+
+    const JsonPath& path() const { return m_path; }
+
+private:
+    JsonPath m_path;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static const JsonPath& compiledPath(const DmxStringValue& path) {
+//
+//Purpose
+//-------
+// the prepared path if there is one, otherwise the per-thread cache
+//
+    const JsonPathState* statePtr = dmxGetPreparedState<JsonPathState>();
+    return (statePtr != NULL) ? statePtr->path() : JsonUtil::compiledPath(path);
+}
+
+DMX_CUSTOM_FUNCTION(JsonExtract, DMX_STRING(value), DMX_STRING(json), DMX_STRING(path)) {
+
+    if (json.isNull() || path.isNull()) {
+        value.setNull();
+    }
+    else if (!JsonUtil::extract(json, compiledPath(path), value)) {
+        // path missing, JSON null or malformed document
+        value.setNull();
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(JsonExtract, JsonPathState, DMX_CONSTANT_ARGUMENT(2))
+
+DMX_CUSTOM_FUNCTION(JsonExists, DMX_INT(found), DMX_STRING(json), DMX_STRING(path)) {
+
+    if (json.isNull() || path.isNull()) {
+        found.setNull();
+    }
+    else {
+        // 1 if the path resolves, 0 otherwise
+        found = JsonUtil::exists(json, compiledPath(path)) ? 1 : 0;
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(JsonExists, JsonPathState, DMX_CONSTANT_ARGUMENT(2))
+
+DMX_CUSTOM_FUNCTION(JsonArrayLength, DMX_INT(length), DMX_STRING(json), DMX_STRING(path)) {
+
+    long long count = -1;
+    if (!json.isNull() && !path.isNull()) {
+        // elements of the array at path
+        count = JsonUtil::arrayLength(json, compiledPath(path));
+    }
+
+    if (count < 0) {
+        length.setNull();
+    }
+    else {
+        length = count;
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(JsonArrayLength, JsonPathState, DMX_CONSTANT_ARGUMENT(2))
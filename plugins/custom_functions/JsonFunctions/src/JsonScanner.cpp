@@ -0,0 +1,205 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <stdint.h>
+#include "JsonUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+static const size_t BLOCK_SIZE = 64;
+static const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+/* Character classes of one block, one bit per byte */
+struct BlockMasks {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t operators;             // { } [ ] : ,
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline bool isOperator(unsigned char c) {
+//
+//Purpose
+//-------
+// JSON structural characters
+//
+    return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void classifyScalar(const unsigned char* block, BlockMasks& masks) {
+//
+//Purpose
+//-------
+// character classes one byte at a time
+//
+    masks.backslash = 0;
+    masks.quote = 0;
+    masks.operators = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        uint64_t bit = static_cast<uint64_t>(1) << i;
+        unsigned char c = block[i];
+        if (c == '\\') {
+            masks.backslash |= bit;
+        } else if (c == '"') {
+            masks.quote |= bit;
+        } else if (isOperator(c)) {
+            masks.operators |= bit;
+        }
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static inline uint64_t matchAvx2(__m256i low, __m256i high, char c) {
+//
+//Purpose
+//-------
+// bit mask of the bytes equal to c in a 64 byte block
+//
+    const __m256i value = _mm256_set1_epi8(c);
+    uint64_t lowMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, value)));
+    uint64_t highMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, value)));
+    return lowMask | (highMask << 32);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static void classifyAvx2(const unsigned char* block, BlockMasks& masks) {
+//
+//Purpose
+//-------
+// character classes with two 32 byte compares per character
+//
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+    masks.backslash = matchAvx2(low, high, '\\');
+    masks.quote = matchAvx2(low, high, '"');
+
+    masks.operators = matchAvx2(low, high, '{') | matchAvx2(low, high, '}')
+                    | matchAvx2(low, high, '[') | matchAvx2(low, high, ']')
+                    | matchAvx2(low, high, ':') | matchAvx2(low, high, ',');
+}
+#endif
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t prefixXor(uint64_t bits) {
+//
+//Purpose
+//-------
+// bit i is the xor of bits 0..i: 1 between an opening and a closing quote
+//
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline unsigned lowestBit(uint64_t bits) {
+//
+//Purpose
+//-------
+// index of the lowest set bit, bits is not 0
+//
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    unsigned index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+JsonScanner::JsonScanner(const char* json, size_t size)
+: m_json(json),
+  m_size(size),
+  m_blockStart(0),
+  m_nextBlock(0),
+  m_structurals(0),
+  m_isInString(0),
+  m_isEscaped(0)
+{
+//
+//Purpose
+//-------
+// nothing is indexed until the first next()
+//
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void JsonScanner::indexBlock() {
+//
+//Purpose
+//-------
+// structural positions of the next 64 bytes (simdjson stage 1): escaped
+// characters from the backslash runs, string interiors from the unescaped
+// quotes, then operators outside strings
+//
+    const unsigned char* block = reinterpret_cast<const unsigned char*>(m_json) + m_nextBlock;
+    unsigned char padded[BLOCK_SIZE];
+    if (m_size - m_nextBlock < BLOCK_SIZE) {
+        memset(padded, ' ', BLOCK_SIZE);
+        memcpy(padded, block, m_size - m_nextBlock);
+        block = padded;
+    }
+
+    BlockMasks masks;
+#if defined(DMX_SIMD_X86)
+    if (dmxCpuHasAvx2()) {
+        classifyAvx2(block, masks);
+    } else {
+        classifyScalar(block, masks);
+    }
+#else
+    classifyScalar(block, masks);
+#endif
+
+    /* a backslash escapes the next byte unless it is escaped itself */
+    uint64_t backslash = masks.backslash & ~m_isEscaped;
+    uint64_t followsEscape = (backslash << 1) | m_isEscaped;
+    uint64_t oddSequenceStarts = backslash & ~EVEN_BITS & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    m_isEscaped = (sequencesStartingOnEvenBits < backslash) ? 1 : 0;
+    uint64_t escaped = (EVEN_BITS ^ (sequencesStartingOnEvenBits << 1)) & followsEscape;
+
+    uint64_t quotes = masks.quote & ~escaped;
+    uint64_t inString = prefixXor(quotes) ^ m_isInString;
+    m_isInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+    m_structurals = masks.operators & ~inString;
+    m_blockStart = m_nextBlock;
+    m_nextBlock += BLOCK_SIZE;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t JsonScanner::next() {
+//
+//Purpose
+//-------
+// pop the next structural position, indexing blocks on demand
+//
+    while (m_structurals == 0) {
+        if (m_nextBlock >= m_size) {
+            return std::string::npos;
+        }
+        indexBlock();
+    }
+    size_t position = m_blockStart + lowestBit(m_structurals);
+    m_structurals &= m_structurals - 1;
+    return position;
+}
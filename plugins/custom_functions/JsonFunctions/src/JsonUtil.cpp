@@ -0,0 +1,660 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <algorithm>
+#include "JsonUtil.h"
+
+/******************************************************************************/
+
+/* Compiled paths kept per thread */
+static const size_t PATH_CACHE_SIZE = 4;
+
+/****************************** MEMBER FUNCTION *******************************/
+static void invalidPath(const DmxStringValue& expression) {
+//
+//Purpose
+//-------
+// report a malformed path expression
+//
+    throw std::invalid_argument("invalid JSON path: " + std::string(expression.data(), expression.size()));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+JsonPath::JsonPath(const DmxStringValue& expression)
+: m_expression(expression)
+{
+//
+//Purpose
+//-------
+// parse $.key, $['key'], $["key"] and $[index] steps; the leading $ may be
+// omitted ("a.b[2]")
+//
+    size_t i = 0;
+    const size_t length = expression.size();
+
+    if (i < length && expression[i] == '$') {
+        i++;
+    } else if (i < length && expression[i] != '.' && expression[i] != '[') {
+        /* bare first key */
+        i = std::string::npos;
+    }
+
+    while (i == std::string::npos || i < length) {
+        JsonPathStep step;
+        step.m_index = 0;
+        step.m_isIndex = false;
+
+        if (i == std::string::npos || expression[i] == '.') {
+            size_t start = (i == std::string::npos) ? 0 : i + 1;
+            size_t end = expression.find_first_of(".[", start);
+            if (end == std::string::npos) {
+                end = length;
+            }
+            if (end == start) {
+                invalidPath(expression);
+            }
+            step.m_key = expression.substr(start, end - start);
+            i = end;
+        } else if (expression[i] == '[' && i + 1 < length && (expression[i + 1] == '\'' || expression[i + 1] == '"')) {
+            char quote = expression[i + 1];
+            size_t j = i + 2;
+            for (; j < length && expression[j] != quote; j++) {
+                if (expression[j] == '\\' && j + 1 < length) {
+                    j++;
+                }
+                step.m_key += expression[j];
+            }
+            if (j + 1 >= length || expression[j + 1] != ']') {
+                invalidPath(expression);
+            }
+            i = j + 2;
+        } else if (expression[i] == '[') {
+            size_t end = expression.find(']', i);
+            if (end == std::string::npos || end == i + 1
+                || expression.find_first_not_of("0123456789", i + 1) != end) {
+                invalidPath(expression);
+            }
+            step.m_index = static_cast<size_t>(strtoull(expression.c_str() + i + 1, NULL, 10));
+            step.m_isIndex = true;
+            i = end + 1;
+        } else {
+            invalidPath(expression);
+        }
+
+        m_steps.push_back(step);
+    }
+}
+
+/******************************************************************************/
+
+/* Most recently used paths of the calling thread, on the host memory callbacks */
+struct JsonPathCache {
+    JsonPath* paths[PATH_CACHE_SIZE];
+    size_t next;
+
+    JsonPathCache() : next(0) {
+        std::fill(paths, paths + PATH_CACHE_SIZE, static_cast<JsonPath*>(NULL));
+    }
+    ~JsonPathCache() {
+        for (size_t i = 0; i < PATH_CACHE_SIZE; i++) {
+            dmxDestroy(paths[i]);
+        }
+    }
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+const JsonPath& JsonUtil::compiledPath(const DmxStringValue &path) {
+//
+//Purpose
+//-------
+// compiled path from the per-thread cache, compiled on a miss
+//
+    static thread_local JsonPathCache cache;
+
+    for (size_t i = 0; i < PATH_CACHE_SIZE; i++) {
+        if (cache.paths[i] != NULL && cache.paths[i]->expression() == path) {
+            return *cache.paths[i];
+        }
+    }
+
+    JsonPath* created = dmxCreate<JsonPath>(path);
+    dmxDestroy(cache.paths[cache.next]);
+    cache.paths[cache.next] = created;
+    cache.next = (cache.next + 1) % PATH_CACHE_SIZE;
+    return *created;
+}
+
+/******************************************************************************/
+
+/* On-demand walk over the structural index. Every structural character before
+   the current value has been read from the scanner; values are skipped by
+   their structurals alone, so nothing past the resolved path is indexed. */
+class JsonWalker
+{
+public:
+    JsonWalker(const DmxStringValue& json)
+    : m_json(json.data()),
+      m_size(json.size()),
+      m_scanner(json.data(), json.size())
+    {
+    }
+
+    static bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    /* first non-blank position at or after position, m_size if none */
+    size_t skipWhitespace(size_t position) const {
+        while (position < m_size && isWhitespace(m_json[position])) {
+            position++;
+        }
+        return position;
+    }
+
+    /* read the structural at position, which must be the next one */
+    bool consume(size_t position) {
+        return m_scanner.next() == position;
+    }
+
+    /* skip the value at position; end is one past its last character */
+    bool skipValue(size_t position, size_t& end) {
+        if (position >= m_size) {
+            return false;
+        }
+        char c = m_json[position];
+        if (c == '{' || c == '[') {
+            if (!consume(position)) {
+                return false;
+            }
+            size_t depth = 1;
+            while (depth != 0) {
+                size_t structural = m_scanner.next();
+                if (structural == std::string::npos) {
+                    return false;
+                }
+                char s = m_json[structural];
+                if (s == '{' || s == '[') {
+                    depth++;
+                } else if (s == '}' || s == ']') {
+                    depth--;
+                }
+                end = structural + 1;
+            }
+            return m_json[end - 1] == ((c == '{') ? '}' : ']');
+        }
+        if (c == '"') {
+            return skipString(position, end);
+        }
+        end = position;
+        while (end < m_size && m_json[end] != ',' && m_json[end] != '}' && m_json[end] != ']'
+               && !isWhitespace(m_json[end])) {
+            end++;
+        }
+        return end > position;
+    }
+
+    /* closing quote of the string starting at position */
+    bool skipString(size_t position, size_t& end) const {
+        for (size_t i = position + 1; i < m_size; ) {
+            const void* quote = memchr(m_json + i, '"', m_size - i);
+            if (quote == NULL) {
+                return false;
+            }
+            size_t q = static_cast<const char*>(quote) - m_json;
+            size_t backslashes = 0;
+            while (q - backslashes > position + 1 && m_json[q - backslashes - 1] == '\\') {
+                backslashes++;
+            }
+            if (backslashes % 2 == 0) {
+                end = q + 1;
+                return true;
+            }
+            i = q + 1;
+        }
+        return false;
+    }
+
+    /* value of member key in the object at position */
+    bool findMember(size_t position, const DmxStringValue& key, size_t& value) {
+        if (!consume(position)) {
+            return false;
+        }
+        size_t cursor = position + 1;
+        size_t first = skipWhitespace(cursor);
+        if (first < m_size && m_json[first] == '}') {
+            return false;
+        }
+        for (;;) {
+            size_t keyStart = skipWhitespace(cursor);
+            size_t colon = m_scanner.next();
+            if (keyStart >= m_size || m_json[keyStart] != '"' || colon == std::string::npos || m_json[colon] != ':') {
+                return false;
+            }
+            size_t keyEnd = colon;
+            while (keyEnd > keyStart + 1 && isWhitespace(m_json[keyEnd - 1])) {
+                keyEnd--;
+            }
+            keyEnd--;
+            if (keyEnd <= keyStart || m_json[keyEnd] != '"') {
+                return false;
+            }
+
+            value = skipWhitespace(colon + 1);
+            if (isKey(m_json + keyStart + 1, keyEnd - keyStart - 1, key)) {
+                return true;
+            }
+
+            /* next member, or the end of the object */
+            size_t end;
+            size_t delimiter;
+            if (!skipValue(value, end) || (delimiter = m_scanner.next()) == std::string::npos
+                || m_json[delimiter] != ',') {
+                return false;
+            }
+            cursor = delimiter + 1;
+        }
+    }
+
+    /* element index of the array at position */
+    bool findElement(size_t position, size_t index, size_t& value) {
+        if (!consume(position)) {
+            return false;
+        }
+        size_t cursor = position + 1;
+        size_t first = skipWhitespace(cursor);
+        if (first < m_size && m_json[first] == ']') {
+            return false;
+        }
+        for (size_t i = 0; ; i++) {
+            value = skipWhitespace(cursor);
+            if (i == index) {
+                return true;
+            }
+            size_t end;
+            size_t delimiter;
+            if (!skipValue(value, end) || (delimiter = m_scanner.next()) == std::string::npos
+                || m_json[delimiter] != ',') {
+                return false;
+            }
+            cursor = delimiter + 1;
+        }
+    }
+
+    /* element count of the array at position, -1 if malformed */
+    long long countElements(size_t position) {
+        if (!consume(position)) {
+            return -1;
+        }
+        size_t first = skipWhitespace(position + 1);
+        if (first < m_size && m_json[first] == ']') {
+            return consume(first) ? 0 : -1;
+        }
+        size_t cursor = position + 1;
+        for (long long count = 1; ; count++) {
+            size_t end;
+            size_t delimiter;
+            if (!skipValue(skipWhitespace(cursor), end) || (delimiter = m_scanner.next()) == std::string::npos) {
+                return -1;
+            }
+            if (m_json[delimiter] == ']') {
+                return count;
+            }
+            if (m_json[delimiter] != ',') {
+                return -1;
+            }
+            cursor = delimiter + 1;
+        }
+    }
+
+    /* compare a raw member name with a path key */
+    bool isKey(const char* raw, size_t length, const DmxStringValue& key) const {
+        if (memchr(raw, '\\', length) == NULL) {
+            return length == key.size() && memcmp(raw, key.data(), length) == 0;
+        }
+        return JsonUtil::unescape(raw, length) == key;
+    }
+
+    const char* json() const { return m_json; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_json;
+    size_t m_size;
+    JsonScanner m_scanner;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static JsonUtil::ValueType resolve(JsonWalker& walker, const JsonPath& path, size_t& begin) {
+//
+//Purpose
+//-------
+// walk the path steps; begin is the first character of the value found
+//
+    const JsonPathSteps& steps = path.steps();
+    size_t position = walker.skipWhitespace(0);
+
+    for (JsonPathSteps::const_iterator step = steps.begin(); step != steps.end(); step++) {
+        if (position >= walker.size()) {
+            return JsonUtil::JSON_MISSING;
+        }
+        char c = walker.json()[position];
+        bool isFound = step->m_isIndex ? (c == '[' && walker.findElement(position, step->m_index, position))
+                                       : (c == '{' && walker.findMember(position, step->m_key, position));
+        if (!isFound) {
+            return JsonUtil::JSON_MISSING;
+        }
+    }
+
+    if (position >= walker.size()) {
+        return JsonUtil::JSON_MISSING;
+    }
+    begin = position;
+    switch (walker.json()[position]) {
+    case '{': return JsonUtil::JSON_OBJECT;
+    case '[': return JsonUtil::JSON_ARRAY;
+    case '"': return JsonUtil::JSON_STRING;
+    case 'n': return JsonUtil::JSON_NULL;
+    case 't':
+    case 'f':
+    case '-':
+        return JsonUtil::JSON_LITERAL;
+    default:
+        return (walker.json()[position] >= '0' && walker.json()[position] <= '9') ? JsonUtil::JSON_LITERAL : JsonUtil::JSON_MISSING;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline bool isDigit(char c) {
+//
+//Purpose
+//-------
+// ASCII decimal digit
+//
+    return c >= '0' && c <= '9';
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool isNumber(const char* text, size_t length) {
+//
+//Purpose
+//-------
+// JSON number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+//
+    size_t i = 0;
+    if (i < length && text[i] == '-') {
+        i++;
+    }
+    if (i < length && text[i] == '0') {
+        i++;
+    } else if (i < length && isDigit(text[i])) {
+        while (i < length && isDigit(text[i])) {
+            i++;
+        }
+    } else {
+        return false;
+    }
+    if (i < length && text[i] == '.') {
+        i++;
+        if (i == length || !isDigit(text[i])) {
+            return false;
+        }
+        while (i < length && isDigit(text[i])) {
+            i++;
+        }
+    }
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        if (i < length && (text[i] == '+' || text[i] == '-')) {
+            i++;
+        }
+        if (i == length || !isDigit(text[i])) {
+            return false;
+        }
+        while (i < length && isDigit(text[i])) {
+            i++;
+        }
+    }
+    return i == length;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool isScalar(JsonUtil::ValueType type, const char* text, size_t length) {
+//
+//Purpose
+//-------
+// null, true, false or a number spelled out in full; resolve only looked at
+// the first character
+//
+    if (type == JsonUtil::JSON_NULL) {
+        return length == 4 && memcmp(text, "null", 4) == 0;
+    }
+    if (text[0] == 't') {
+        return length == 4 && memcmp(text, "true", 4) == 0;
+    }
+    if (text[0] == 'f') {
+        return length == 5 && memcmp(text, "false", 5) == 0;
+    }
+    return isNumber(text, length);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+JsonUtil::ValueType JsonUtil::find(const DmxStringValue &json, const JsonPath &path, size_t &begin, size_t &end) {
+//
+//Purpose
+//-------
+// locate the value at path; malformed documents and misspelled literals or
+// numbers read as missing
+//
+    JsonWalker walker(json);
+    ValueType type = resolve(walker, path, begin);
+    if (type == JSON_MISSING || !walker.skipValue(begin, end)) {
+        return JSON_MISSING;
+    }
+    if ((type == JSON_NULL || type == JSON_LITERAL) && !isScalar(type, json.data() + begin, end - begin)) {
+        return JSON_MISSING;
+    }
+    return type;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool JsonUtil::extract(const DmxStringValue &json, const JsonPath &path, DmxStringValue &value) {
+//
+//Purpose
+//-------
+// string values are unescaped, other values keep their JSON text
+//
+    size_t begin;
+    size_t end;
+    ValueType type = find(json, path, begin, end);
+
+    if (type == JSON_MISSING || type == JSON_NULL) {
+        return false;
+    }
+    if (type == JSON_STRING) {
+        value = unescape(json.data() + begin + 1, end - begin - 2);
+    } else {
+        value.assign(json, begin, end - begin);
+    }
+    return true;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool JsonUtil::extract(const DmxStringValue &json, const DmxStringValue &path, DmxStringValue &value) {
+//
+//Purpose
+//-------
+// extract with a cached compiled path
+//
+    return extract(json, compiledPath(path), value);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool JsonUtil::exists(const DmxStringValue &json, const JsonPath &path) {
+//
+//Purpose
+//-------
+// path resolves to any value, null included; the value is checked the way
+// extract checks it so the two agree
+//
+    size_t begin;
+    size_t end;
+    return find(json, path, begin, end) != JSON_MISSING;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool JsonUtil::exists(const DmxStringValue &json, const DmxStringValue &path) {
+//
+//Purpose
+//-------
+// exists with a cached compiled path
+//
+    return exists(json, compiledPath(path));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long JsonUtil::arrayLength(const DmxStringValue &json, const JsonPath &path) {
+//
+//Purpose
+//-------
+// count the elements without looking inside them
+//
+    size_t begin;
+    JsonWalker walker(json);
+    if (resolve(walker, path, begin) != JSON_ARRAY) {
+        return -1;
+    }
+    return walker.countElements(begin);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long JsonUtil::arrayLength(const DmxStringValue &json, const DmxStringValue &path) {
+//
+//Purpose
+//-------
+// arrayLength with a cached compiled path
+//
+    return arrayLength(json, compiledPath(path));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline int hexDigit(char c) {
+//
+//Purpose
+//-------
+// value of a hex digit, -1 if c is not one
+//
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool readCodeUnit(const char* text, size_t length, size_t i, unsigned& unit) {
+//
+//Purpose
+//-------
+// the 4 hex digits of a \u escape starting at text[i]
+//
+    if (i + 4 > length) {
+        return false;
+    }
+    unit = 0;
+    for (size_t k = 0; k < 4; k++) {
+        int digit = hexDigit(text[i + k]);
+        if (digit < 0) {
+            return false;
+        }
+        unit = (unit << 4) | static_cast<unsigned>(digit);
+    }
+    return true;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void appendUtf8(DmxStringValue& output, unsigned codePoint) {
+//
+//Purpose
+//-------
+// UTF-8 encoding of a code point
+//
+    if (codePoint < 0x80) {
+        output += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        output += static_cast<char>(0xC0 | (codePoint >> 6));
+        output += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        output += static_cast<char>(0xE0 | (codePoint >> 12));
+        output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        output += static_cast<char>(0xF0 | (codePoint >> 18));
+        output += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue JsonUtil::unescape(const char* text, size_t length) {
+//
+//Purpose
+//-------
+// decode \" \\ \/ \b \f \n \r \t and \uXXXX (surrogate pairs to one code
+// point); invalid escapes are kept as written
+//
+    DmxStringValue output;
+    output.reserve(length);
+
+    for (size_t i = 0; i < length; ) {
+        const void* backslash = memchr(text + i, '\\', length - i);
+        size_t next = (backslash == NULL) ? length : static_cast<size_t>(static_cast<const char*>(backslash) - text);
+        output.append(text + i, next - i);
+        i = next;
+        if (i + 1 >= length) {
+            output.append(text + i, length - i);
+            break;
+        }
+
+        char escape = text[i + 1];
+        i += 2;
+        switch (escape) {
+        case '"':  output += '"'; break;
+        case '\\': output += '\\'; break;
+        case '/':  output += '/'; break;
+        case 'b':  output += '\b'; break;
+        case 'f':  output += '\f'; break;
+        case 'n':  output += '\n'; break;
+        case 'r':  output += '\r'; break;
+        case 't':  output += '\t'; break;
+        case 'u': {
+            unsigned unit;
+            if (!readCodeUnit(text, length, i, unit)) {
+                output += "\\u";
+                break;
+            }
+            i += 4;
+            unsigned low;
+            if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < length && text[i] == '\\' && text[i + 1] == 'u'
+                && readCodeUnit(text, length, i + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            }
+            appendUtf8(output, unit);
+            break;
+        }
+        default:
+            output += '\\';
+            output += escape;
+            break;
+        }
+    }
+
+    return output;
+}
@@ -0,0 +1,93 @@
+#ifndef LookupUtil_h
+#define LookupUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <istream>
+#include <stdint.h>
+#include "dmx_custom_functions.h"
+/******************************************************************************/
+/* Compiled dictionary file layout
+
+   header | bloom filter | key hashes | entries | key/value data
+
+   Entries are sorted by key hash so a lookup is a Bloom filter probe, an
+   interpolation search over the dense hash array and a key comparison.
+   All integers are stored in host byte order; every section starts on a
+   64 byte boundary. */
+
+#define LOOKUP_DICTIONARY_MAGIC         "DMXDICT"
+#define LOOKUP_DICTIONARY_VERSION       1
+
+struct LookupDictionaryHeader
+{
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_bloomHashes;         // bits set per key inside one bloom block
+    uint64_t m_entryCount;
+    uint64_t m_bloomBlocks;         // number of 512 bit blocks, a power of two
+    uint64_t m_bloomOffset;
+    uint64_t m_hashOffset;
+    uint64_t m_entryOffset;
+    uint64_t m_dataOffset;
+    uint64_t m_fileSize;
+};
+
+struct LookupDictionaryEntry
+{
+    uint64_t m_keyOffset;           // relative to m_dataOffset, value follows the key
+    uint32_t m_keyLength;
+    uint32_t m_valueLength;
+};
+
+/******************************************************************************/
+
+class LookupDictionary
+{
+public:
+    // map a compiled dictionary file read-only
+    explicit LookupDictionary(const std::string& path);
+    ~LookupDictionary();
+
+    // find the value of a key, false if the key is not present
+    bool find(const char* key, size_t keyLength, DmxStringValue& value) const;
+
+    size_t size() const { return static_cast<size_t>(m_header->m_entryCount); }
+
+private:
+    LookupDictionary(const LookupDictionary&);
+    LookupDictionary& operator=(const LookupDictionary&);
+
+    bool mayContain(uint64_t hash) const;
+    void unmap();
+
+    void* m_mappingPtr;
+    size_t m_mappingSize;
+    void* m_fileHandle;
+    const LookupDictionaryHeader* m_header;
+    const uint64_t* m_bloom;
+    const uint64_t* m_hashes;
+    const LookupDictionaryEntry* m_entries;
+    const char* m_data;
+};
+
+class LookupUtil
+{
+public:
+    // look up a key in a compiled dictionary, opened once per process
+    static bool lookupValue(const DmxStringValue& key, const DmxStringValue& dictPath, DmxStringValue& value);
+
+    // process-wide shared dictionary for a path
+    static const LookupDictionary& openDictionary(const DmxStringValue& dictPath);
+
+    // compile "key,value" CSV records into a dictionary file, returns the number of keys
+    static size_t compileCsv(std::istream& csv, const std::string& outputPath, bool skipHeader, size_t& duplicates);
+
+    // 64 bit key hash shared by the compiler and the lookup
+    static uint64_t hashKey(const char* key, size_t keyLength);
+};
+
+#endif /* LookupUtil_h */
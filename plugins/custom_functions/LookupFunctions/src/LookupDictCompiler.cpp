@@ -0,0 +1,55 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Compile a key,value CSV file into the memory-mapped dictionary format read
+ by LookupValue.
+
+ Usage: LookupDictCompiler [--skip-header] input.csv output.dict
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "LookupUtil.h"
+
+/******************************************************************************/
+
+int main(int argc, char* argv[]) {
+
+    bool skipHeader = false;
+    int argIndex = 1;
+    if (argIndex < argc && strcmp(argv[argIndex], "--skip-header") == 0) {
+        skipHeader = true;
+        argIndex++;
+    }
+    if (argc - argIndex != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--skip-header] input.csv output.dict" << std::endl;
+        return 2;
+    }
+
+    std::ifstream csv(argv[argIndex], std::ios::binary);
+    if (!csv) {
+        std::cerr << "cannot open " << argv[argIndex] << std::endl;
+        return 1;
+    }
+
+    try {
+        size_t duplicates = 0;
+        size_t keys = LookupUtil::compileCsv(csv, argv[argIndex + 1], skipHeader, duplicates);
+        std::cout << keys << " keys written to " << argv[argIndex + 1];
+        if (duplicates != 0) {
+            std::cout << ", " << duplicates << " duplicate keys ignored";
+        }
+        std::cout << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,17 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "LookupUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(LookupValue, DMX_STRING(value), DMX_STRING(key), DMX_STRING(dictPath)) {
+
+    if (key.isNull() || dictPath.isNull()) {
+        value.setNull();
+    }
+    else if (!LookupUtil::lookupValue(key, dictPath, value)) {
+        // key not in the dictionary
+        value.setNull();
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
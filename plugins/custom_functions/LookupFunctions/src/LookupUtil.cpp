@@ -0,0 +1,574 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+#include "LookupUtil.h"
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) || defined(__WIN32__)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/******************************************************************************/
+
+/* Bloom filter sizing: one 512 bit block per key probe keeps a miss to one cache line */
+static const uint64_t BLOOM_BLOCK_BITS = 512;
+static const uint64_t BLOOM_BLOCK_WORDS = BLOOM_BLOCK_BITS / 64;
+static const uint64_t BLOOM_BITS_PER_KEY = 10;
+static const uint32_t BLOOM_HASHES = 6;
+
+/* Section alignment inside the dictionary file */
+static const uint64_t SECTION_ALIGNMENT = 64;
+
+/* Environment variable requesting transparent huge pages for dictionary mappings */
+static const char* const HUGE_PAGES_ENVIRONMENT = "DMX_LOOKUP_HUGE_PAGES";
+
+/****************************** MEMBER FUNCTION *******************************/
+uint64_t LookupUtil::hashKey(const char* key, size_t keyLength) {
+//
+//Purpose
+//-------
+// MurmurHash64A; reads eight bytes per step
+//
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = 0x8445d61a4e774912ULL ^ (keyLength * m);
+
+    const char* data = key;
+    const char* end = key + (keyLength & ~static_cast<size_t>(7));
+    for (; data != end; data += 8) {
+        uint64_t k;
+        memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (keyLength & 7) {
+    case 7: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[6])) << 48;
+            /* fall through */
+    case 6: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[5])) << 40;
+            /* fall through */
+    case 5: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[4])) << 32;
+            /* fall through */
+    case 4: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[3])) << 24;
+            /* fall through */
+    case 3: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[2])) << 16;
+            /* fall through */
+    case 2: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[1])) << 8;
+            /* fall through */
+    case 1: h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[0]));
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static uint64_t bloomBlock(uint64_t hash, uint64_t bloomBlocks) {
+//
+//Purpose
+//-------
+// block of the bloom filter holding all bits of a key
+//
+    return (hash >> 32) & (bloomBlocks - 1);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static uint32_t bloomBit(uint64_t hash, uint32_t i) {
+//
+//Purpose
+//-------
+// i-th bit of a key inside its bloom block (double hashing)
+//
+    uint32_t h1 = static_cast<uint32_t>(hash);
+    uint32_t h2 = ((h1 >> 16) | (h1 << 16)) | 1;
+    return (h1 + i * h2) & static_cast<uint32_t>(BLOOM_BLOCK_BITS - 1);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static uint64_t alignSection(uint64_t offset) {
+//
+//Purpose
+//-------
+// round a file offset up to the section alignment
+//
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool isRangeWithin(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t limit) {
+//
+//Purpose
+//-------
+// offset + count * elementSize <= limit, without overflowing on hostile headers
+//
+    return offset <= limit && count <= (limit - offset) / elementSize;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+LookupDictionary::LookupDictionary(const std::string& path)
+: m_mappingPtr(NULL),
+  m_mappingSize(0),
+  m_fileHandle(NULL),
+  m_header(NULL),
+  m_bloom(NULL),
+  m_hashes(NULL),
+  m_entries(NULL),
+  m_data(NULL)
+{
+//
+//Purpose
+//-------
+// map the dictionary read-only and validate its layout
+//
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) || defined(__WIN32__)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("cannot open dictionary " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(LookupDictionaryHeader))) {
+        CloseHandle(file);
+        throw std::runtime_error("invalid dictionary " + path);
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        throw std::runtime_error("cannot map dictionary " + path);
+    }
+    m_mappingPtr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_mappingPtr == NULL) {
+        CloseHandle(mapping);
+        throw std::runtime_error("cannot map dictionary " + path);
+    }
+    m_fileHandle = mapping;
+    m_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open dictionary " + path);
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(LookupDictionaryHeader))) {
+        ::close(fd);
+        throw std::runtime_error("invalid dictionary " + path);
+    }
+    m_mappingSize = static_cast<size_t>(fileStat.st_size);
+    void* mappingPtr = mmap(NULL, m_mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mappingPtr == MAP_FAILED) {
+        throw std::runtime_error("cannot map dictionary " + path);
+    }
+    m_mappingPtr = mappingPtr;
+
+#if defined(MADV_HUGEPAGE)
+    const char* hugePages = getenv(HUGE_PAGES_ENVIRONMENT);
+    if (hugePages != NULL && *hugePages != '\0' && *hugePages != '0') {
+        /* best effort: not every file system backs file mappings with huge pages */
+        madvise(m_mappingPtr, m_mappingSize, MADV_HUGEPAGE);
+    }
+#endif
+#endif
+
+    const char* base = static_cast<const char*>(m_mappingPtr);
+    m_header = reinterpret_cast<const LookupDictionaryHeader*>(base);
+
+    bool isValid = memcmp(m_header->m_magic, LOOKUP_DICTIONARY_MAGIC, sizeof(LOOKUP_DICTIONARY_MAGIC)) == 0
+        && m_header->m_version == LOOKUP_DICTIONARY_VERSION
+        && m_header->m_fileSize == m_mappingSize
+        && m_header->m_bloomBlocks != 0
+        && (m_header->m_bloomBlocks & (m_header->m_bloomBlocks - 1)) == 0
+        && isRangeWithin(m_header->m_bloomOffset, m_header->m_bloomBlocks, BLOOM_BLOCK_WORDS * sizeof(uint64_t),
+                         m_header->m_hashOffset)
+        && isRangeWithin(m_header->m_hashOffset, m_header->m_entryCount, sizeof(uint64_t), m_header->m_entryOffset)
+        && isRangeWithin(m_header->m_entryOffset, m_header->m_entryCount, sizeof(LookupDictionaryEntry),
+                         m_header->m_dataOffset)
+        && m_header->m_dataOffset <= m_header->m_fileSize;
+    if (!isValid) {
+        unmap();
+        throw std::runtime_error("invalid dictionary " + path);
+    }
+
+    m_bloom = reinterpret_cast<const uint64_t*>(base + m_header->m_bloomOffset);
+    m_hashes = reinterpret_cast<const uint64_t*>(base + m_header->m_hashOffset);
+    m_entries = reinterpret_cast<const LookupDictionaryEntry*>(base + m_header->m_entryOffset);
+    m_data = base + m_header->m_dataOffset;
+
+    /* every key and value inside the data section, checked once so find() can trust the entries */
+    uint64_t dataSize = m_header->m_fileSize - m_header->m_dataOffset;
+    for (uint64_t i = 0; i < m_header->m_entryCount; i++) {
+        uint64_t recordLength = static_cast<uint64_t>(m_entries[i].m_keyLength) + m_entries[i].m_valueLength;
+        if (!isRangeWithin(m_entries[i].m_keyOffset, recordLength, 1, dataSize)) {
+            unmap();
+            throw std::runtime_error("invalid dictionary " + path);
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+LookupDictionary::~LookupDictionary() {
+//
+//Purpose
+//-------
+// release the mapping
+//
+    unmap();
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void LookupDictionary::unmap() {
+//
+//Purpose
+//-------
+// unmap the dictionary
+//
+    if (m_mappingPtr == NULL) {
+        return;
+    }
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) || defined(__WIN32__)
+    UnmapViewOfFile(m_mappingPtr);
+    CloseHandle(static_cast<HANDLE>(m_fileHandle));
+#else
+    munmap(m_mappingPtr, m_mappingSize);
+#endif
+    m_mappingPtr = NULL;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool LookupDictionary::mayContain(uint64_t hash) const {
+//
+//Purpose
+//-------
+// bloom filter probe, false means the key is certainly absent
+//
+    const uint64_t* block = m_bloom + bloomBlock(hash, m_header->m_bloomBlocks) * BLOOM_BLOCK_WORDS;
+    for (uint32_t i = 0; i < m_header->m_bloomHashes; i++) {
+        uint32_t bit = bloomBit(hash, i);
+        if ((block[bit >> 6] & (static_cast<uint64_t>(1) << (bit & 63))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool LookupDictionary::find(const char* key, size_t keyLength, DmxStringValue& value) const {
+//
+//Purpose
+//-------
+// bloom filter, interpolation search over the sorted hashes, key comparison
+//
+    uint64_t hash = LookupUtil::hashKey(key, keyLength);
+    if (!mayContain(hash)) {
+        return false;
+    }
+
+    const uint64_t* begin = m_hashes;
+    const uint64_t* end = m_hashes + m_header->m_entryCount;
+
+    /* hashes are uniformly distributed: a few interpolation steps narrow the range */
+    for (int step = 0; step < 8 && end - begin > 32; step++) {
+        uint64_t lowHash = *begin;
+        uint64_t highHash = *(end - 1);
+        if (hash <= lowHash) {
+            end = begin + 1;
+            break;
+        }
+        if (hash > highHash) {
+            return false;
+        }
+        double fraction = static_cast<double>(hash - lowHash) / static_cast<double>(highHash - lowHash);
+        size_t guess = static_cast<size_t>(fraction * static_cast<double>(end - begin - 1));
+        const uint64_t* probe = begin + std::min(guess, static_cast<size_t>(end - begin - 1));
+        if (*probe < hash) {
+            begin = probe + 1;
+        } else {
+            end = probe + 1;
+        }
+    }
+
+    const uint64_t* entryHash = std::lower_bound(begin, end, hash);
+    const uint64_t* hashesEnd = m_hashes + m_header->m_entryCount;
+    for (; entryHash != hashesEnd && *entryHash == hash; entryHash++) {
+        const LookupDictionaryEntry& entry = m_entries[entryHash - m_hashes];
+        const char* entryKey = m_data + entry.m_keyOffset;
+        if (entry.m_keyLength == keyLength && memcmp(entryKey, key, keyLength) == 0) {
+            value.assign(entryKey + entry.m_keyLength, entry.m_valueLength);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************/
+
+/* Process-wide dictionaries, mapped on first use and kept until unload; they
+   outlive every call, so they stay off the per-call memory accounting */
+class LookupDictionaryRegistry
+{
+public:
+    ~LookupDictionaryRegistry() {
+        for (std::map<std::string, LookupDictionary*>::iterator it = m_dictionaries.begin(); it != m_dictionaries.end(); it++) {
+            delete it->second;
+        }
+    }
+    const LookupDictionary& open(const std::string& path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<std::string, LookupDictionary*>::iterator it = m_dictionaries.find(path);
+        if (it == m_dictionaries.end()) {
+            it = m_dictionaries.insert(std::make_pair(path, new LookupDictionary(path))).first;
+        }
+        return *it->second;
+    }
+private:
+    std::mutex m_mutex;
+    std::map<std::string, LookupDictionary*> m_dictionaries;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+const LookupDictionary& LookupUtil::openDictionary(const DmxStringValue &dictPath) {
+//
+//Purpose
+//-------
+// shared dictionary for a path; the last one used by a thread is found
+// without taking the registry lock
+//
+    static LookupDictionaryRegistry registry;
+    static thread_local DmxStringValue lastPath;
+    static thread_local const LookupDictionary* lastDictionary = NULL;
+
+    if (lastDictionary == NULL || lastPath != dictPath) {
+        lastDictionary = &registry.open(std::string(dictPath.data(), dictPath.size()));
+        lastPath = dictPath;
+    }
+    return *lastDictionary;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool LookupUtil::lookupValue(const DmxStringValue &key, const DmxStringValue &dictPath, DmxStringValue &value) {
+//
+//Purpose
+//-------
+// value of a key in a compiled dictionary, false if the key is not present
+//
+    return openDictionary(dictPath).find(key.data(), key.size(), value);
+}
+
+/******************************************************************************/
+
+struct LookupRecord {
+    uint64_t hash;
+    std::string key;
+    std::string value;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool compareRecords(const LookupRecord& lhs, const LookupRecord& rhs) {
+//
+//Purpose
+//-------
+// dictionary order: by hash, then by key
+//
+    if (lhs.hash != rhs.hash) {
+        return lhs.hash < rhs.hash;
+    }
+    return lhs.key < rhs.key;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool readCsvRecord(std::streambuf& csv, std::vector<std::string>& fields) {
+//
+//Purpose
+//-------
+// read one RFC 4180 record; quoted fields may contain separators, doubled
+// quotes and line breaks
+//
+    fields.clear();
+    int c = csv.sgetc();
+    if (c == std::char_traits<char>::eof()) {
+        return false;
+    }
+
+    std::string field;
+    bool isQuoted = false;
+    for (c = csv.sbumpc(); c != std::char_traits<char>::eof(); c = csv.sbumpc()) {
+        if (isQuoted) {
+            if (c == '"') {
+                if (csv.sgetc() == '"') {
+                    field += '"';
+                    csv.sbumpc();
+                } else {
+                    isQuoted = false;
+                }
+            } else {
+                field += static_cast<char>(c);
+            }
+        } else if (c == '"') {
+            isQuoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (c == '\n') {
+            break;
+        } else if (c != '\r') {
+            field += static_cast<char>(c);
+        }
+    }
+    fields.push_back(field);
+    return true;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void writePadding(std::ofstream& output, uint64_t& offset, uint64_t target) {
+//
+//Purpose
+//-------
+// zero fill up to the next section
+//
+    static const char zeros[SECTION_ALIGNMENT] = { 0 };
+    output.write(zeros, static_cast<std::streamsize>(target - offset));
+    offset = target;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t LookupUtil::compileCsv(std::istream &csv, const std::string &outputPath, bool skipHeader, size_t &duplicates) {
+//
+//Purpose
+//-------
+// build a dictionary file from key,value CSV records; for duplicate keys
+// the first record wins
+//
+    std::vector<LookupRecord> records;
+    std::vector<std::string> fields;
+    std::streambuf& csvBuffer = *csv.rdbuf();
+
+    if (skipHeader) {
+        readCsvRecord(csvBuffer, fields);
+    }
+    while (readCsvRecord(csvBuffer, fields)) {
+        if (fields.size() == 1 && fields[0].empty()) {
+            continue;
+        }
+        if (fields.size() != 2) {
+            throw std::runtime_error("expected key,value record near key '" + fields[0] + "'");
+        }
+        LookupRecord record;
+        record.hash = hashKey(fields[0].data(), fields[0].size());
+        record.key.swap(fields[0]);
+        record.value.swap(fields[1]);
+        records.push_back(record);
+    }
+
+    std::stable_sort(records.begin(), records.end(), compareRecords);
+
+    duplicates = 0;
+    std::vector<LookupRecord>::iterator last = records.begin();
+    for (std::vector<LookupRecord>::iterator it = records.begin(); it != records.end(); it++) {
+        if (it != records.begin() && it->hash == (last - 1)->hash && it->key == (last - 1)->key) {
+            duplicates++;
+            continue;
+        }
+        if (last != it) {
+            last->hash = it->hash;
+            last->key.swap(it->key);
+            last->value.swap(it->value);
+        }
+        last++;
+    }
+    records.erase(last, records.end());
+
+    /* bloom filter */
+    uint64_t bloomBlocks = 1;
+    while (bloomBlocks * BLOOM_BLOCK_BITS < records.size() * BLOOM_BITS_PER_KEY) {
+        bloomBlocks <<= 1;
+    }
+    std::vector<uint64_t> bloom(bloomBlocks * BLOOM_BLOCK_WORDS, 0);
+    for (size_t i = 0; i < records.size(); i++) {
+        uint64_t* block = &bloom[bloomBlock(records[i].hash, bloomBlocks) * BLOOM_BLOCK_WORDS];
+        for (uint32_t j = 0; j < BLOOM_HASHES; j++) {
+            uint32_t bit = bloomBit(records[i].hash, j);
+            block[bit >> 6] |= static_cast<uint64_t>(1) << (bit & 63);
+        }
+    }
+
+    /* layout */
+    LookupDictionaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, LOOKUP_DICTIONARY_MAGIC, sizeof(LOOKUP_DICTIONARY_MAGIC));
+    header.m_version = LOOKUP_DICTIONARY_VERSION;
+    header.m_bloomHashes = BLOOM_HASHES;
+    header.m_entryCount = records.size();
+    header.m_bloomBlocks = bloomBlocks;
+    header.m_bloomOffset = alignSection(sizeof(header));
+    header.m_hashOffset = alignSection(header.m_bloomOffset + bloom.size() * sizeof(uint64_t));
+    header.m_entryOffset = alignSection(header.m_hashOffset + records.size() * sizeof(uint64_t));
+    header.m_dataOffset = alignSection(header.m_entryOffset + records.size() * sizeof(LookupDictionaryEntry));
+
+    std::vector<LookupDictionaryEntry> entries(records.size());
+    uint64_t dataSize = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].key.size() > UINT32_MAX || records[i].value.size() > UINT32_MAX) {
+            throw std::runtime_error("key or value too long near key '" + records[i].key.substr(0, 64) + "'");
+        }
+        entries[i].m_keyOffset = dataSize;
+        entries[i].m_keyLength = static_cast<uint32_t>(records[i].key.size());
+        entries[i].m_valueLength = static_cast<uint32_t>(records[i].value.size());
+        dataSize += records[i].key.size() + records[i].value.size();
+    }
+    header.m_fileSize = header.m_dataOffset + dataSize;
+
+    /* write */
+    std::ofstream output(outputPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!output) {
+        throw std::runtime_error("cannot create dictionary " + outputPath);
+    }
+
+    uint64_t offset = sizeof(header);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writePadding(output, offset, header.m_bloomOffset);
+    output.write(reinterpret_cast<const char*>(&bloom[0]), static_cast<std::streamsize>(bloom.size() * sizeof(uint64_t)));
+    offset += bloom.size() * sizeof(uint64_t);
+    writePadding(output, offset, header.m_hashOffset);
+    for (size_t i = 0; i < records.size(); i++) {
+        output.write(reinterpret_cast<const char*>(&records[i].hash), sizeof(uint64_t));
+    }
+    offset += records.size() * sizeof(uint64_t);
+    writePadding(output, offset, header.m_entryOffset);
+    if (!entries.empty()) {
+        output.write(reinterpret_cast<const char*>(&entries[0]), static_cast<std::streamsize>(entries.size() * sizeof(LookupDictionaryEntry)));
+    }
+    offset += entries.size() * sizeof(LookupDictionaryEntry);
+    writePadding(output, offset, header.m_dataOffset);
+    for (size_t i = 0; i < records.size(); i++) {
+        output.write(records[i].key.data(), static_cast<std::streamsize>(records[i].key.size()));
+        output.write(records[i].value.data(), static_cast<std::streamsize>(records[i].value.size()));
+    }
+
+    output.close();
+    if (!output) {
+        throw std::runtime_error("cannot write dictionary " + outputPath);
+    }
+
+    return records.size();
+}
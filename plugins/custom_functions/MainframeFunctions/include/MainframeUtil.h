@@ -0,0 +1,53 @@
+#ifndef MainframeUtil_h
+#define MainframeUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+/******************************************************************************/
+
+static const size_t MAX_PACKED_LENGTH = 16;         // 31 digits and the sign
+static const size_t MAX_ZONED_LENGTH = 31;
+static const int MAX_DECIMAL_SCALE = 31;
+
+/* Mainframe data conversions. The single byte side of a code page conversion
+   is ISO-8859-1, which is ASCII for the EBCDIC invariant characters; every
+   code page maps all 256 byte values, so translation never fails */
+class MainframeUtil
+{
+public:
+    // EBCDIC code pages, selected by their number
+    enum CodePage {
+        CODE_PAGE_037   = 37,           // US, Canada
+        CODE_PAGE_500   = 500,          // International
+        CODE_PAGE_1047  = 1047          // Latin 1 open systems
+    };
+
+    // Translate size EBCDIC bytes into size ISO-8859-1 bytes
+    static void ebcdicToAscii(const char* ebcdic, size_t size, int codePage, char* text);
+
+    // Translate size ISO-8859-1 bytes into size EBCDIC bytes
+    static void asciiToEbcdic(const char* text, size_t size, int codePage, char* ebcdic);
+
+    // Translate EBCDIC into at most outputCapacity bytes of UTF-8, ending on a
+    // whole character; returns the length written
+    static size_t ebcdicToUtf8(const char* ebcdic, size_t size, int codePage, char* utf8, size_t outputCapacity);
+
+    // Packed decimal (COMP-3): two digits per byte and the sign in the last
+    // low nibble, A C E F positive and B D negative. scale is the number of
+    // implied decimal places; the integer forms drop them, truncating toward zero
+    static long long packedToInt(const char* bytes, size_t size, int scale);
+    static double packedToDouble(const char* bytes, size_t size, int scale);
+
+    // Zoned decimal: one EBCDIC digit 0xF0..0xF9 per byte, the zone of the
+    // last byte is the sign
+    static long long zonedToInt(const char* bytes, size_t size, int scale);
+
+    // Packed decimal of digits digits in digits / 2 + 1 bytes, sign C or D;
+    // returns the length written
+    static size_t intToPacked(long long value, int digits, char* bytes, size_t outputCapacity);
+};
+
+#endif /* MainframeUtil_h */
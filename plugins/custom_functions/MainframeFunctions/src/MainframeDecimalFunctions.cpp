@@ -0,0 +1,57 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "MainframeUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(PackedToInt, DMX_INT(value), DMX_STRING(input), DMX_INT(scale)) {
+
+    if (input.isNull() || scale.isNull()) {
+        value.setNull();
+    }
+    else {
+        // COMP-3 field, implied decimal places dropped
+        value = MainframeUtil::packedToInt(input.data(), input.size(), static_cast<int>(static_cast<long long>(scale)));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(PackedToDouble, DMX_DOUBLE(value), DMX_STRING(input), DMX_INT(scale)) {
+
+    if (input.isNull() || scale.isNull()) {
+        value.setNull();
+    }
+    else {
+        // COMP-3 field with scale implied decimal places
+        value = MainframeUtil::packedToDouble(input.data(), input.size(), static_cast<int>(static_cast<long long>(scale)));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(ZonedToInt, DMX_INT(value), DMX_STRING(input), DMX_INT(scale)) {
+
+    if (input.isNull() || scale.isNull()) {
+        value.setNull();
+    }
+    else {
+        // zoned decimal field, implied decimal places dropped
+        value = MainframeUtil::zonedToInt(input.data(), input.size(), static_cast<int>(static_cast<long long>(scale)));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(IntToPacked, DMX_STRING(packed), DMX_INT(value), DMX_INT(digits)) {
+
+    if (value.isNull() || digits.isNull()) {
+        packed.setNull();
+    }
+    else {
+        // COMP-3 field of digits / 2 + 1 bytes, written straight into the output buffer
+        packed.setOutputLength(MainframeUtil::intToPacked(value, static_cast<int>(static_cast<long long>(digits)),
+                                                          packed.getOutputData(), packed.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
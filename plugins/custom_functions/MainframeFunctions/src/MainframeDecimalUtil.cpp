@@ -0,0 +1,433 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <stdint.h>
+#include "MainframeUtil.h"
+
+/******************************************************************************/
+
+static const uint64_t POWERS_OF_TEN[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static const double DOUBLE_POWERS_OF_TEN[MAX_DECIMAL_SCALE + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28, 1e29, 1e30, 1e31
+};
+
+static const uint64_t SIXTEEN_DIGITS = 10000000000000000ULL;
+static const uint64_t EIGHT_DIGITS = 100000000ULL;
+static const uint64_t INT_MAGNITUDE_LIMIT = 0x7FFFFFFFFFFFFFFFULL;
+
+static const uint64_t LOW_NIBBLES = 0x0F0F0F0F0F0F0F0FULL;
+static const uint64_t HIGH_NIBBLES = 0xF0F0F0F0F0F0F0F0ULL;
+
+/* Magnitude of a decimal field, split after its last 16 digits */
+struct DecimalDigits {
+    uint64_t high;                  // at most 15 digits
+    uint64_t low;                   // 16 digits
+    bool isNegative;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t loadBigEndian(const unsigned char* bytes) {
+//
+//Purpose
+//-------
+// big endian 64 bit word
+//
+    return (static_cast<uint64_t>(bytes[0]) << 56) | (static_cast<uint64_t>(bytes[1]) << 48)
+         | (static_cast<uint64_t>(bytes[2]) << 40) | (static_cast<uint64_t>(bytes[3]) << 32)
+         | (static_cast<uint64_t>(bytes[4]) << 24) | (static_cast<uint64_t>(bytes[5]) << 16)
+         | (static_cast<uint64_t>(bytes[6]) << 8) | static_cast<uint64_t>(bytes[7]);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t loadBigEndian32(const unsigned char* bytes) {
+//
+//Purpose
+//-------
+// big endian 32 bit word
+//
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16)
+         | (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t loadBigEndianPartial(const unsigned char* bytes, size_t size) {
+//
+//Purpose
+//-------
+// big endian value of 0 to 8 bytes from two overlapping loads, so a field is
+// read in place instead of through a copy the loads would stall on
+//
+    if (size >= 4) {
+        return (static_cast<uint64_t>(loadBigEndian32(bytes)) << (8 * (size - 4))) | loadBigEndian32(bytes + size - 4);
+    }
+    if (size == 0) {
+        return 0;
+    }
+    return (static_cast<uint64_t>(bytes[0]) << (8 * (size - 1)))
+         | (static_cast<uint64_t>(bytes[size / 2]) << (8 * (size - 1 - size / 2))) | bytes[size - 1];
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline void loadField(const unsigned char* bytes, size_t size, uint64_t padding, uint64_t* words, size_t count) {
+//
+//Purpose
+//-------
+// the field right aligned in count big endian words, the bytes before it
+// taken from padding
+//
+    for (size_t i = count; i-- > 0; ) {
+        size_t length = (size < 8) ? size : 8;
+        size -= length;
+        words[i] = (length == 8) ? loadBigEndian(bytes + size)
+                                 : (loadBigEndianPartial(bytes + size, length) | (padding << (8 * length)));
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline bool isNegativeSign(unsigned sign) {
+//
+//Purpose
+//-------
+// B and D are negative, A C E F positive
+//
+    return sign == 0xB || sign == 0xD;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline bool hasInvalidNibble(uint64_t nibbles) {
+//
+//Purpose
+//-------
+// a nibble above 9 has bit 3 set together with bit 2 or bit 1
+//
+    return (nibbles & ((nibbles << 1) | (nibbles << 2)) & 0x8888888888888888ULL) != 0;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t packedToBinary(uint64_t nibbles) {
+//
+//Purpose
+//-------
+// 16 BCD digits, most significant first, to binary: each step merges the two
+// halves of every lane, high * 10^n + low, by subtracting high * (2^k - 10^n)
+//
+    nibbles -= 6 * ((nibbles >> 4) & LOW_NIBBLES);
+    nibbles -= 156 * ((nibbles >> 8) & 0x00FF00FF00FF00FFULL);
+    nibbles -= 55536 * ((nibbles >> 16) & 0x0000FFFF0000FFFFULL);
+    return (nibbles >> 32) * EIGHT_DIGITS + (nibbles & 0xFFFFFFFFULL);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t zonedToBinary(uint64_t digits) {
+//
+//Purpose
+//-------
+// eight digit bytes 0..9, most significant first, to binary
+//
+    digits -= 246 * ((digits >> 8) & 0x00FF00FF00FF00FFULL);
+    digits -= 65436 * ((digits >> 16) & 0x0000FFFF0000FFFFULL);
+    return (digits >> 32) * 10000 + (digits & 0xFFFFFFFFULL);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t binaryToPacked(uint64_t value) {
+//
+//Purpose
+//-------
+// value below 10^8 to 8 BCD digits: split into one digit per byte, dividing
+// every lane by 10^n with a multiply and shift, then pack the bytes into nibbles
+//
+    uint64_t digits = ((value / 10000) << 32) | (value % 10000);
+    uint64_t quotients = ((digits * 5243) >> 19) & 0x0000007F0000007FULL;
+    digits = (quotients << 16) | (digits - 100 * quotients);
+    quotients = ((digits * 103) >> 10) & 0x000F000F000F000FULL;
+    digits = (quotients << 8) | (digits - 10 * quotients);
+
+    digits = (digits | (digits >> 4)) & 0x00FF00FF00FF00FFULL;
+    digits = (digits | (digits >> 8)) & 0x0000FFFF0000FFFFULL;
+    return (digits | (digits >> 16)) & 0xFFFFFFFFULL;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void throwInvalidScale(int scale) {
+//
+//Purpose
+//-------
+// implied decimal places out of range
+//
+    char message[64];
+    snprintf(message, sizeof(message), "invalid decimal scale %d, expected 0 to %d", scale, MAX_DECIMAL_SCALE);
+    throw std::invalid_argument(message);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void throwInvalidLength(const char* type, size_t size, size_t maxLength) {
+//
+//Purpose
+//-------
+// field of no bytes or of more than maxLength
+//
+    char message[96];
+    snprintf(message, sizeof(message), "invalid %s decimal of %lu bytes, expected 1 to %lu",
+             type, static_cast<unsigned long>(size), static_cast<unsigned long>(maxLength));
+    throw std::runtime_error(message);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void throwInvalidPacked(const unsigned char* bytes, size_t size) {
+//
+//Purpose
+//-------
+// locate the first bad nibble of a field that failed the word checks
+//
+    char message[80];
+    for (size_t i = 0; i < size; i++) {
+        unsigned high = bytes[i] >> 4;
+        unsigned low = bytes[i] & 0x0F;
+        if (high > 9 || (i + 1 < size && low > 9)) {
+            snprintf(message, sizeof(message), "invalid packed decimal digit 0x%X at offset %lu",
+                     (high > 9) ? high : low, static_cast<unsigned long>(i));
+            throw std::runtime_error(message);
+        }
+    }
+    snprintf(message, sizeof(message), "invalid packed decimal sign 0x%X", bytes[size - 1] & 0x0F);
+    throw std::runtime_error(message);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void throwInvalidZoned(const unsigned char* bytes, size_t size) {
+//
+//Purpose
+//-------
+// locate the first bad byte of a field that failed the word checks
+//
+    char message[80];
+    for (size_t i = 0; i + 1 < size; i++) {
+        if ((bytes[i] & 0xF0) != 0xF0 || (bytes[i] & 0x0F) > 9) {
+            snprintf(message, sizeof(message), "invalid zoned decimal digit 0x%02X at offset %lu",
+                     bytes[i], static_cast<unsigned long>(i));
+            throw std::runtime_error(message);
+        }
+    }
+    snprintf(message, sizeof(message), "invalid zoned decimal sign digit 0x%02X", bytes[size - 1]);
+    throw std::runtime_error(message);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline void dropNibbles(uint64_t& high, uint64_t& low, unsigned count) {
+//
+//Purpose
+//-------
+// shift the last count digits out of the nibbles high:low
+//
+    if (count >= 16) {
+        low = high >> (4 * (count - 16));
+        high = 0;
+    }
+    else if (count != 0) {
+        low = (low >> (4 * count)) | (high << (64 - 4 * count));
+        high >>= 4 * count;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline DecimalDigits decodePacked(const char* bytes, size_t size, unsigned droppedDigits) {
+//
+//Purpose
+//-------
+// the field right aligned in two zero words is 31 digit nibbles and the sign;
+// dropped digits are shifted out after the checks, so scaling needs no division
+//
+    if (size == 0 || size > MAX_PACKED_LENGTH) {
+        throwInvalidLength("packed", size, MAX_PACKED_LENGTH);
+    }
+
+    uint64_t words[2];
+    loadField(reinterpret_cast<const unsigned char*>(bytes), size, 0, words, 2);
+    uint64_t first = words[0];
+    uint64_t second = words[1];
+
+    unsigned sign = static_cast<unsigned>(second & 0x0F);
+    uint64_t highNibbles = first >> 4;
+    uint64_t lowNibbles = (first << 60) | (second >> 4);
+    if (hasInvalidNibble(highNibbles) || hasInvalidNibble(lowNibbles) || sign < 0xA) {
+        throwInvalidPacked(reinterpret_cast<const unsigned char*>(bytes), size);
+    }
+    dropNibbles(highNibbles, lowNibbles, droppedDigits);
+
+    DecimalDigits digits;
+    digits.high = (highNibbles != 0) ? packedToBinary(highNibbles) : 0;
+    digits.low = packedToBinary(lowNibbles);
+    digits.isNegative = isNegativeSign(sign);
+    return digits;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline DecimalDigits decodeZoned(const char* bytes, size_t size, unsigned droppedDigits) {
+//
+//Purpose
+//-------
+// the field right aligned in four words of EBCDIC zeros is 32 digits; the
+// sign zone is replaced by the digit zone before the checks, and dropped
+// digits are left out of a second load
+//
+    if (size == 0 || size > MAX_ZONED_LENGTH) {
+        throwInvalidLength("zoned", size, MAX_ZONED_LENGTH);
+    }
+
+    const unsigned char* field = reinterpret_cast<const unsigned char*>(bytes);
+    uint64_t words[4];
+    loadField(field, size, HIGH_NIBBLES, words, 4);
+    unsigned sign = static_cast<unsigned>(words[3] >> 4) & 0x0F;
+    words[3] |= 0xF0;
+
+    uint64_t badBytes = 0;
+    for (size_t i = 0; i < 4; i++) {
+        badBytes |= (words[i] & HIGH_NIBBLES) ^ HIGH_NIBBLES;
+        badBytes |= ((words[i] & LOW_NIBBLES) + 0x0606060606060606ULL) & HIGH_NIBBLES;
+    }
+    if (badBytes != 0 || sign < 0xA) {
+        throwInvalidZoned(field, size);
+    }
+
+    if (droppedDigits != 0) {
+        loadField(field, (size > droppedDigits) ? size - droppedDigits : 0, HIGH_NIBBLES, words, 4);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        words[i] &= LOW_NIBBLES;
+    }
+
+    DecimalDigits digits;
+    digits.high = ((words[0] | words[1]) != 0) ? zonedToBinary(words[0]) * EIGHT_DIGITS + zonedToBinary(words[1]) : 0;
+    digits.low = zonedToBinary(words[2]) * EIGHT_DIGITS + zonedToBinary(words[3]);
+    digits.isNegative = isNegativeSign(sign);
+    return digits;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline long long toInteger(const DecimalDigits& digits, const char* type) {
+//
+//Purpose
+//-------
+// high * 10^16 + low with its sign; the range check only matters above 16 digits
+//
+    uint64_t magnitude = digits.low;
+    if (digits.high != 0) {
+        uint64_t limit = digits.isNegative ? INT_MAGNITUDE_LIMIT + 1 : INT_MAGNITUDE_LIMIT;
+        if (digits.high > (limit - digits.low) / SIXTEEN_DIGITS) {
+            char message[64];
+            snprintf(message, sizeof(message), "%s decimal value exceeds the integer range", type);
+            throw std::runtime_error(message);
+        }
+        magnitude += digits.high * SIXTEEN_DIGITS;
+    }
+
+    if (digits.isNegative && magnitude != 0) {
+        return -static_cast<long long>(magnitude - 1) - 1;
+    }
+    return static_cast<long long>(magnitude);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long MainframeUtil::packedToInt(const char* bytes, size_t size, int scale) {
+//
+//Purpose
+//-------
+// packed decimal to integer
+//
+    if (scale < 0 || scale > MAX_DECIMAL_SCALE) {
+        throwInvalidScale(scale);
+    }
+    return toInteger(decodePacked(bytes, size, static_cast<unsigned>(scale)), "packed");
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+double MainframeUtil::packedToDouble(const char* bytes, size_t size, int scale) {
+//
+//Purpose
+//-------
+// packed decimal to the nearest double of its digits, divided by 10^scale
+//
+    if (scale < 0 || scale > MAX_DECIMAL_SCALE) {
+        throwInvalidScale(scale);
+    }
+    DecimalDigits digits = decodePacked(bytes, size, 0);
+
+    double value = static_cast<double>(digits.low);
+    if (digits.high != 0) {
+        value += static_cast<double>(digits.high) * DOUBLE_POWERS_OF_TEN[16];
+    }
+    value /= DOUBLE_POWERS_OF_TEN[scale];
+    return (digits.isNegative && value != 0) ? -value : value;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long MainframeUtil::zonedToInt(const char* bytes, size_t size, int scale) {
+//
+//Purpose
+//-------
+// zoned decimal to integer
+//
+    if (scale < 0 || scale > MAX_DECIMAL_SCALE) {
+        throwInvalidScale(scale);
+    }
+    return toInteger(decodeZoned(bytes, size, static_cast<unsigned>(scale)), "zoned");
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t MainframeUtil::intToPacked(long long value, int digits, char* bytes, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// integer to a packed decimal field of digits digits
+//
+    if (digits < 1 || digits > 2 * static_cast<int>(MAX_PACKED_LENGTH) - 1) {
+        char message[64];
+        snprintf(message, sizeof(message), "invalid packed decimal digits %d, expected 1 to %d",
+                 digits, 2 * static_cast<int>(MAX_PACKED_LENGTH) - 1);
+        throw std::invalid_argument(message);
+    }
+
+    uint64_t magnitude = (value < 0) ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    if (digits < 20 && magnitude >= POWERS_OF_TEN[digits]) {
+        char message[80];
+        snprintf(message, sizeof(message), "value %lld does not fit %d packed decimal digits", value, digits);
+        throw std::runtime_error(message);
+    }
+
+    size_t length = static_cast<size_t>(digits) / 2 + 1;
+    if (length > outputCapacity) {
+        char message[96];
+        snprintf(message, sizeof(message), "packed decimal of %lu bytes exceeds the output buffer of %lu bytes",
+                 static_cast<unsigned long>(length), static_cast<unsigned long>(outputCapacity));
+        throw std::runtime_error(message);
+    }
+
+    /* 31 digit nibbles and the sign as two big endian words */
+    uint64_t low = magnitude % SIXTEEN_DIGITS;
+    uint64_t lowNibbles = (binaryToPacked(low / EIGHT_DIGITS) << 32) | binaryToPacked(low % EIGHT_DIGITS);
+    uint64_t highNibbles = binaryToPacked(magnitude / SIXTEEN_DIGITS);
+    uint64_t words[2];
+    words[0] = (highNibbles << 4) | (lowNibbles >> 60);
+    words[1] = (lowNibbles << 4) | ((value < 0) ? 0x0D : 0x0C);
+
+    unsigned char field[MAX_PACKED_LENGTH];
+    for (size_t i = 0; i < MAX_PACKED_LENGTH; i++) {
+        field[i] = static_cast<unsigned char>(words[i / 8] >> (8 * (7 - i % 8)));
+    }
+    memcpy(bytes, field + MAX_PACKED_LENGTH - length, length);
+    return length;
+}
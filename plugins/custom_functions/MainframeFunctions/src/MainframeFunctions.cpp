@@ -0,0 +1,51 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "MainframeUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(EbcdicToAscii, DMX_STRING(text), DMX_STRING(input), DMX_INT(codePage)) {
+
+    if (input.isNull() || codePage.isNull()) {
+        text.setNull();
+    }
+    else {
+        // one byte per byte, written straight into the output buffer
+        size_t length = (input.size() < text.getOutputCapacity()) ? input.size() : text.getOutputCapacity();
+        MainframeUtil::ebcdicToAscii(input.data(), length, static_cast<int>(static_cast<long long>(codePage)),
+                                     text.getOutputData());
+        text.setOutputLength(length);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(AsciiToEbcdic, DMX_STRING(ebcdic), DMX_STRING(input), DMX_INT(codePage)) {
+
+    if (input.isNull() || codePage.isNull()) {
+        ebcdic.setNull();
+    }
+    else {
+        // one byte per byte, written straight into the output buffer
+        size_t length = (input.size() < ebcdic.getOutputCapacity()) ? input.size() : ebcdic.getOutputCapacity();
+        MainframeUtil::asciiToEbcdic(input.data(), length, static_cast<int>(static_cast<long long>(codePage)),
+                                     ebcdic.getOutputData());
+        ebcdic.setOutputLength(length);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(EbcdicToUtf8, DMX_STRING(text), DMX_STRING(input), DMX_INT(codePage)) {
+
+    if (input.isNull() || codePage.isNull()) {
+        text.setNull();
+    }
+    else {
+        // one or two bytes per byte, written straight into the output buffer
+        text.setOutputLength(MainframeUtil::ebcdicToUtf8(input.data(), input.size(),
+                                                         static_cast<int>(static_cast<long long>(codePage)),
+                                                         text.getOutputData(), text.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
@@ -0,0 +1,309 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include "dmx_custom_functions.h"
+#include "MainframeUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+/* Bytes translated between two polls of the cancel token */
+static const size_t POLL_BLOCK_SIZE = 65536;
+
+/* Bytes translated at a time before the UTF-8 expansion */
+static const size_t UTF8_BLOCK_SIZE = 4096;
+
+/* EBCDIC to ISO-8859-1 of code page 037, one row per high nibble */
+static const unsigned char CODE_PAGE_037_TO_LATIN1[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x9C, 0x09, 0x86, 0x7F, 0x97, 0x8D, 0x8E, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x9D, 0x85, 0x08, 0x87, 0x18, 0x19, 0x92, 0x8F, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x0A, 0x17, 0x1B, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x05, 0x06, 0x07,
+    0x90, 0x91, 0x16, 0x93, 0x94, 0x95, 0x96, 0x04, 0x98, 0x99, 0x9A, 0x9B, 0x14, 0x15, 0x9E, 0x1A,
+    0x20, 0xA0, 0xE2, 0xE4, 0xE0, 0xE1, 0xE3, 0xE5, 0xE7, 0xF1, 0xA2, 0x2E, 0x3C, 0x28, 0x2B, 0x7C,
+    0x26, 0xE9, 0xEA, 0xEB, 0xE8, 0xED, 0xEE, 0xEF, 0xEC, 0xDF, 0x21, 0x24, 0x2A, 0x29, 0x3B, 0xAC,
+    0x2D, 0x2F, 0xC2, 0xC4, 0xC0, 0xC1, 0xC3, 0xC5, 0xC7, 0xD1, 0xA6, 0x2C, 0x25, 0x5F, 0x3E, 0x3F,
+    0xF8, 0xC9, 0xCA, 0xCB, 0xC8, 0xCD, 0xCE, 0xCF, 0xCC, 0x60, 0x3A, 0x23, 0x40, 0x27, 0x3D, 0x22,
+    0xD8, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0xAB, 0xBB, 0xF0, 0xFD, 0xFE, 0xB1,
+    0xB0, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70, 0x71, 0x72, 0xAA, 0xBA, 0xE6, 0xB8, 0xC6, 0xA4,
+    0xB5, 0x7E, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0xA1, 0xBF, 0xD0, 0xDD, 0xDE, 0xAE,
+    0x5E, 0xA3, 0xA5, 0xB7, 0xA9, 0xA7, 0xB6, 0xBC, 0xBD, 0xBE, 0x5B, 0x5D, 0xAF, 0xA8, 0xB4, 0xD7,
+    0x7B, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0xAD, 0xF4, 0xF6, 0xF2, 0xF3, 0xF5,
+    0x7D, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x51, 0x52, 0xB9, 0xFB, 0xFC, 0xF9, 0xFA, 0xFF,
+    0x5C, 0xF7, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0xB2, 0xD4, 0xD6, 0xD2, 0xD3, 0xD5,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0xB3, 0xDB, 0xDC, 0xD9, 0xDA, 0x9F
+};
+
+/* A byte where a code page differs from code page 037 */
+struct CodePageChange {
+    unsigned char ebcdic;
+    unsigned char latin1;
+};
+
+static const CodePageChange CODE_PAGE_500_CHANGES[] = {
+    { 0x4A, 0x5B }, { 0x4F, 0x21 }, { 0x5A, 0x5D }, { 0x5F, 0x5E }, { 0xB0, 0xA2 }, { 0xBA, 0xAC }, { 0xBB, 0x7C }
+};
+
+static const CodePageChange CODE_PAGE_1047_CHANGES[] = {
+    { 0x5F, 0x5E }, { 0xAD, 0x5B }, { 0xB0, 0xAC }, { 0xBA, 0xDD }, { 0xBB, 0xA8 }, { 0xBD, 0x5D }
+};
+
+/* Both directions of one code page */
+struct CodePageTables {
+    unsigned char toLatin1[256];
+    unsigned char toEbcdic[256];
+
+    CodePageTables(const CodePageChange* changes, size_t numChanges)
+    {
+        memcpy(toLatin1, CODE_PAGE_037_TO_LATIN1, sizeof(toLatin1));
+        for (size_t i = 0; i < numChanges; i++) {
+            toLatin1[changes[i].ebcdic] = changes[i].latin1;
+        }
+        for (size_t i = 0; i < 256; i++) {
+            toEbcdic[toLatin1[i]] = static_cast<unsigned char>(i);
+        }
+    }
+};
+
+/* Built once when the library is loaded */
+static const CodePageTables CODE_PAGE_037_TABLES(NULL, 0);
+static const CodePageTables CODE_PAGE_500_TABLES(CODE_PAGE_500_CHANGES,
+                                                 sizeof(CODE_PAGE_500_CHANGES) / sizeof(CODE_PAGE_500_CHANGES[0]));
+static const CodePageTables CODE_PAGE_1047_TABLES(CODE_PAGE_1047_CHANGES,
+                                                  sizeof(CODE_PAGE_1047_CHANGES) / sizeof(CODE_PAGE_1047_CHANGES[0]));
+
+typedef void (*TranslateFunction)(const unsigned char* input, size_t size, const unsigned char* table,
+                                  unsigned char* output);
+
+/****************************** MEMBER FUNCTION *******************************/
+static const CodePageTables& codePageTables(int codePage) {
+//
+//Purpose
+//-------
+// tables of a code page number
+//
+    switch (codePage) {
+    case MainframeUtil::CODE_PAGE_037:
+        return CODE_PAGE_037_TABLES;
+    case MainframeUtil::CODE_PAGE_500:
+        return CODE_PAGE_500_TABLES;
+    case MainframeUtil::CODE_PAGE_1047:
+        return CODE_PAGE_1047_TABLES;
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "unsupported EBCDIC code page %d, expected 37, 500 or 1047", codePage);
+    throw std::invalid_argument(message);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void translateScalar(const unsigned char* input, size_t size, const unsigned char* table,
+                            unsigned char* output) {
+//
+//Purpose
+//-------
+// one table lookup per byte
+//
+    for (size_t i = 0; i < size; i++) {
+        output[i] = table[input[i]];
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_SSSE3
+static void translateSsse3(const unsigned char* input, size_t size, const unsigned char* table,
+                           unsigned char* output) {
+//
+//Purpose
+//-------
+// 16 bytes per step: pshufb looks up the low nibble in each 16 byte row of
+// the table; subtracting the row from the byte and adding 0x70 with
+// saturation leaves bit 7 clear only in the bytes of that row, and pshufb
+// returns zero for the others
+//
+    const __m128i rowStep = _mm_set1_epi8(0x10);
+    const __m128i rowBias = _mm_set1_epi8(0x70);
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i result = _mm_setzero_si128();
+        for (size_t r = 0; r < 16; r++) {
+            __m128i entries = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * r));
+            result = _mm_or_si128(result, _mm_shuffle_epi8(entries, _mm_adds_epu8(row, rowBias)));
+            row = _mm_sub_epi8(row, rowStep);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), result);
+    }
+
+    translateScalar(input + i, size - i, table, output + i);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static void translateAvx2(const unsigned char* input, size_t size, const unsigned char* table,
+                          unsigned char* output) {
+//
+//Purpose
+//-------
+// the SSSE3 lookup on 32 bytes per step, each table row in both lanes
+//
+    const __m256i rowStep = _mm256_set1_epi8(0x10);
+    const __m256i rowBias = _mm256_set1_epi8(0x70);
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i result = _mm256_setzero_si256();
+        for (size_t r = 0; r < 16; r++) {
+            __m256i entries = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * r)));
+            result = _mm256_or_si256(result, _mm256_shuffle_epi8(entries, _mm256_adds_epu8(row, rowBias)));
+            row = _mm256_sub_epi8(row, rowStep);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), result);
+    }
+
+    translateScalar(input + i, size - i, table, output + i);
+}
+#endif
+
+/****************************** MEMBER FUNCTION *******************************/
+static TranslateFunction selectTranslate() {
+//
+//Purpose
+//-------
+// widest lookup the CPU runs
+//
+#if defined(DMX_SIMD_X86)
+    if (dmxCpuHasAvx2()) {
+        return translateAvx2;
+    }
+    if (dmxCpuHasSsse3()) {
+        return translateSsse3;
+    }
+#endif
+    return translateScalar;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static TranslateFunction translateKernel() {
+//
+//Purpose
+//-------
+// kernel selected on first use
+//
+    static const TranslateFunction kernel = selectTranslate();
+    return kernel;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void translate(const char* input, size_t size, const unsigned char* table, char* output) {
+//
+//Purpose
+//-------
+// translate in blocks, polling the cancel token between them
+//
+    TranslateFunction translateBlock = translateKernel();
+    DmxStopPoller poller(POLL_BLOCK_SIZE);
+
+    for (size_t blockStart = 0; blockStart < size; blockStart += POLL_BLOCK_SIZE) {
+        size_t blockLength = std::min(size - blockStart, POLL_BLOCK_SIZE);
+        translateBlock(reinterpret_cast<const unsigned char*>(input) + blockStart, blockLength, table,
+                  reinterpret_cast<unsigned char*>(output) + blockStart);
+        poller.tick(static_cast<long long>(blockLength));
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline bool isAscii(const unsigned char* bytes, size_t size) {
+//
+//Purpose
+//-------
+// no byte with bit 7 set, eight bytes at a time
+//
+    uint64_t highBits = 0;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        highBits |= word;
+    }
+    for (; i < size; i++) {
+        highBits |= bytes[i];
+    }
+    return (highBits & 0x8080808080808080ULL) == 0;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void MainframeUtil::ebcdicToAscii(const char* ebcdic, size_t size, int codePage, char* text) {
+//
+//Purpose
+//-------
+// EBCDIC to ISO-8859-1
+//
+    translate(ebcdic, size, codePageTables(codePage).toLatin1, text);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void MainframeUtil::asciiToEbcdic(const char* text, size_t size, int codePage, char* ebcdic) {
+//
+//Purpose
+//-------
+// ISO-8859-1 to EBCDIC
+//
+    translate(text, size, codePageTables(codePage).toEbcdic, ebcdic);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t MainframeUtil::ebcdicToUtf8(const char* ebcdic, size_t size, int codePage, char* utf8, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// EBCDIC to ISO-8859-1 a block at a time; ASCII blocks are copied, bytes
+// 0x80..0xFF become two byte UTF-8 sequences
+//
+    const unsigned char* table = codePageTables(codePage).toLatin1;
+    unsigned char* output = reinterpret_cast<unsigned char*>(utf8);
+    TranslateFunction translateBlock = translateKernel();
+    unsigned char block[UTF8_BLOCK_SIZE];
+    DmxStopPoller poller(POLL_BLOCK_SIZE);
+    size_t o = 0;
+
+    for (size_t blockStart = 0; blockStart < size; blockStart += UTF8_BLOCK_SIZE) {
+        size_t blockLength = std::min(size - blockStart, UTF8_BLOCK_SIZE);
+        translateBlock(reinterpret_cast<const unsigned char*>(ebcdic) + blockStart, blockLength, table, block);
+
+        if (isAscii(block, blockLength) && outputCapacity - o >= blockLength) {
+            memcpy(output + o, block, blockLength);
+            o += blockLength;
+        }
+        else {
+            for (size_t i = 0; i < blockLength; i++) {
+                unsigned char c = block[i];
+                if (c < 0x80) {
+                    if (o == outputCapacity) {
+                        return o;
+                    }
+                    output[o++] = c;
+                }
+                else {
+                    if (outputCapacity - o < 2) {
+                        return o;
+                    }
+                    output[o++] = static_cast<unsigned char>(0xC0 | (c >> 6));
+                    output[o++] = static_cast<unsigned char>(0x80 | (c & 0x3F));
+                }
+            }
+        }
+        poller.tick(static_cast<long long>(blockLength));
+    }
+
+    return o;
+}
@@ -0,0 +1,52 @@
+#ifndef SortKeyUtil_h
+#define SortKeyUtil_h
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <time.h>
+#include "dmx_custom_functions.h"
+/******************************************************************************/
+
+static const size_t NUMERIC_KEY_LENGTH = 8;
+static const size_t DATE_TIME_KEY_LENGTH = 17;
+static const size_t MAX_KEY_FIELDS = 9;
+
+/* Binary sort keys: two values compare like their keys under memcmp, shorter
+   key first on a common prefix. Keys delimit themselves, so the keys of
+   several fields can be concatenated into a key of the tuple */
+class SortKeyUtil
+{
+public:
+    // key options
+    enum KeyOptions {
+        SORTKEY_CASE_FOLD   = 1,        // ASCII letters compare case-insensitively
+        SORTKEY_TRIM        = 2,        // leading and trailing ASCII whitespace is ignored
+        SORTKEY_DESCENDING  = 4
+    };
+
+    // Each function writes a key of at most outputCapacity bytes and returns
+    // its length; a key that does not fit throws, a truncated key would not
+    // keep the order.
+
+    // bytes with 0x00 escaped as 0x00 0xFF, then the terminator 0x00 0x01;
+    // at most 2 * size + 2 bytes
+    static size_t stringKey(const DmxStringValue& text, unsigned options, char* output, size_t outputCapacity);
+    // IEEE 754 bits with the sign flipped, negative values inverted; -0 is 0
+    // and NaN sorts after infinity; NUMERIC_KEY_LENGTH bytes
+    static size_t doubleKey(double value, unsigned options, char* output, size_t outputCapacity);
+    // two's complement with the sign flipped, big endian; NUMERIC_KEY_LENGTH bytes
+    static size_t intKey(long long value, unsigned options, char* output, size_t outputCapacity);
+    // year, month, day, hour, minute, second and the fractional second;
+    // DATE_TIME_KEY_LENGTH bytes
+    static size_t dateTimeKey(const struct tm& dateTime, double fractionalSecond, unsigned options,
+                              char* output, size_t outputCapacity);
+
+    // field keys in order, each behind a marker byte: 0x00 for a null field
+    // (nulls first), 0x01 before a key
+    static size_t concatKeys(const DmxStringValue* const* keyPtrs, size_t numKeys, char* output, size_t outputCapacity);
+};
+
+#endif /* SortKeyUtil_h */
@@ -0,0 +1,77 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "SortKeyUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(SortKeyString, DMX_STRING(key), DMX_STRING(text), DMX_INT(options)) {
+
+    if (text.isNull() || options.isNull()) {
+        key.setNull();
+    }
+    else {
+        // options: 1 case fold, 2 trim, 4 descending
+        key.setOutputLength(SortKeyUtil::stringKey(text, static_cast<unsigned>(static_cast<long long>(options)),
+                                                   key.getOutputData(), key.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(SortKeyDouble, DMX_STRING(key), DMX_DOUBLE(value), DMX_INT(options)) {
+
+    if (value.isNull() || options.isNull()) {
+        key.setNull();
+    }
+    else {
+        // options: 4 descending
+        key.setOutputLength(SortKeyUtil::doubleKey(value, static_cast<unsigned>(static_cast<long long>(options)),
+                                                   key.getOutputData(), key.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(SortKeyInt, DMX_STRING(key), DMX_INT(value), DMX_INT(options)) {
+
+    if (value.isNull() || options.isNull()) {
+        key.setNull();
+    }
+    else {
+        // options: 4 descending
+        key.setOutputLength(SortKeyUtil::intKey(value, static_cast<unsigned>(static_cast<long long>(options)),
+                                                key.getOutputData(), key.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(SortKeyDateTime, DMX_STRING(key), DMX_DATE_TIME(value), DMX_INT(options)) {
+
+    if (value.isNull() || options.isNull()) {
+        key.setNull();
+    }
+    else {
+        // options: 4 descending
+        key.setOutputLength(SortKeyUtil::dateTimeKey(value.getTime(), value.getFractionalSecond(),
+                                                     static_cast<unsigned>(static_cast<long long>(options)),
+                                                     key.getOutputData(), key.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(SortKeyConcat, DMX_STRING(key), DMX_STRING(key1), DMX_STRING(key2), DMX_STRING(key3),
+                    DMX_STRING(key4), DMX_STRING(key5), DMX_STRING(key6), DMX_STRING(key7), DMX_STRING(key8),
+                    DMX_STRING(key9)) {
+
+    const DmxString* fields[MAX_KEY_FIELDS] = { &key1, &key2, &key3, &key4, &key5, &key6, &key7, &key8, &key9 };
+    const DmxStringValue* keyPtrs[MAX_KEY_FIELDS];
+    for (size_t i = 0; i < MAX_KEY_FIELDS; i++) {
+        keyPtrs[i] = fields[i]->isNull() ? NULL : fields[i];
+    }
+
+    // null fields sort first; unused trailing fields may be passed as null
+    key.setOutputLength(SortKeyUtil::concatKeys(keyPtrs, MAX_KEY_FIELDS, key.getOutputData(), key.getOutputCapacity()));
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
@@ -0,0 +1,304 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <stdint.h>
+#include "SortKeyUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+static const unsigned STRING_OPTIONS = SortKeyUtil::SORTKEY_CASE_FOLD | SortKeyUtil::SORTKEY_TRIM
+                                     | SortKeyUtil::SORTKEY_DESCENDING;
+static const unsigned NUMERIC_OPTIONS = SortKeyUtil::SORTKEY_DESCENDING;
+
+static const unsigned char KEY_ESCAPE = 0x00;
+static const unsigned char KEY_ESCAPED_ZERO = 0xFF;
+static const unsigned char KEY_TERMINATOR = 0x01;
+
+static const unsigned char FIELD_NULL = 0x00;
+static const unsigned char FIELD_PRESENT = 0x01;
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkOptions(unsigned options, unsigned allowed) {
+//
+//Purpose
+//-------
+// reject options the key type does not have
+//
+    if ((options & ~allowed) != 0) {
+        char message[64];
+        snprintf(message, sizeof(message), "invalid sort key options: %u", options);
+        throw std::invalid_argument(message);
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkCapacity(size_t length, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// a key is never truncated
+//
+    if (length > outputCapacity) {
+        char message[96];
+        snprintf(message, sizeof(message), "sort key of %lu bytes exceeds the output buffer of %lu bytes",
+                 static_cast<unsigned long>(length), static_cast<unsigned long>(outputCapacity));
+        throw std::runtime_error(message);
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline bool isAsciiSpace(unsigned char c) {
+//
+//Purpose
+//-------
+// space, tab, line feed, vertical tab, form feed, carriage return
+//
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline void storeBigEndian(uint64_t value, unsigned char flip, unsigned char* output, size_t length) {
+//
+//Purpose
+//-------
+// the low length bytes of value, most significant first, xor flip
+//
+    for (size_t i = 0; i < length; i++) {
+        output[i] = static_cast<unsigned char>(value >> (8 * (length - 1 - i))) ^ flip;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint64_t orderedDoubleBits(double value) {
+//
+//Purpose
+//-------
+// bits that compare as unsigned integers like the doubles they encode
+//
+    uint64_t bits;
+    if (value != value) {
+        bits = 0x7FF8000000000000ULL;           // one NaN, above infinity
+    } else if (value == 0) {
+        bits = 0;                               // -0 equals 0
+    } else {
+        memcpy(&bits, &value, sizeof(bits));
+    }
+    const uint64_t signBit = 0x8000000000000000ULL;
+    return (bits & signBit) ? ~bits : (bits | signBit);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline size_t encodeByte(unsigned char c, bool caseFold, unsigned char flip, unsigned char* output) {
+//
+//Purpose
+//-------
+// one byte of a string key, 0x00 escaped; returns the bytes written
+//
+    if (c == 0) {
+        output[0] = KEY_ESCAPE ^ flip;
+        output[1] = KEY_ESCAPED_ZERO ^ flip;
+        return 2;
+    }
+    if (caseFold && c >= 'A' && c <= 'Z') {
+        c += 'a' - 'A';
+    }
+    output[0] = c ^ flip;
+    return 1;
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static size_t encodeAvx2(const unsigned char* text, size_t& i, size_t end,
+                         bool caseFold, unsigned char flip, unsigned char* output) {
+//
+//Purpose
+//-------
+// 32 byte blocks without 0x00 are folded and flipped with vector operations;
+// blocks with 0x00 go through the scalar escape; returns the bytes written
+//
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i beforeUpper = _mm256_set1_epi8('A' - 1);
+    const __m256i afterUpper = _mm256_set1_epi8('Z' + 1);
+    const __m256i caseBit = _mm256_set1_epi8(caseFold ? 0x20 : 0);
+    const __m256i flipBits = _mm256_set1_epi8(static_cast<char>(flip));
+    size_t o = 0;
+
+    while (i + 32 <= end) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, zero)) != 0) {
+            for (size_t blockEnd = i + 32; i < blockEnd; i++) {
+                o += encodeByte(text[i], caseFold, flip, output + o);
+            }
+            continue;
+        }
+
+        /* signed compares: bytes 0x80..0xFF are below 'A' */
+        __m256i isUpper = _mm256_and_si256(_mm256_cmpgt_epi8(block, beforeUpper), _mm256_cmpgt_epi8(afterUpper, block));
+        block = _mm256_xor_si256(block, _mm256_and_si256(isUpper, caseBit));
+        block = _mm256_xor_si256(block, flipBits);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + o), block);
+        o += 32;
+        i += 32;
+    }
+
+    return o;
+}
+#endif
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t encodeString(const unsigned char* text, size_t length, unsigned options, unsigned char* output) {
+//
+//Purpose
+//-------
+// string key into an output of at least 2 * length + 2 bytes
+//
+    size_t begin = 0;
+    size_t end = length;
+    if (options & SortKeyUtil::SORTKEY_TRIM) {
+        while (begin < end && isAsciiSpace(text[begin])) {
+            begin++;
+        }
+        while (end > begin && isAsciiSpace(text[end - 1])) {
+            end--;
+        }
+    }
+
+    bool caseFold = (options & SortKeyUtil::SORTKEY_CASE_FOLD) != 0;
+    unsigned char flip = (options & SortKeyUtil::SORTKEY_DESCENDING) ? 0xFF : 0x00;
+    size_t i = begin;
+    size_t o = 0;
+
+#if defined(DMX_SIMD_X86)
+    if (dmxCpuHasAvx2()) {
+        o = encodeAvx2(text, i, end, caseFold, flip, output);
+    }
+#endif
+
+    for (; i < end; i++) {
+        o += encodeByte(text[i], caseFold, flip, output + o);
+    }
+
+    output[o++] = KEY_ESCAPE ^ flip;
+    output[o++] = KEY_TERMINATOR ^ flip;
+    return o;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SortKeyUtil::stringKey(const DmxStringValue &text, unsigned options, char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// string key; encoded in place when the worst case fits the output
+//
+    checkOptions(options, STRING_OPTIONS);
+
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(text.data());
+    size_t worstCase = 2 * text.size() + 2;
+
+    if (outputCapacity >= worstCase) {
+        return encodeString(input, text.size(), options, reinterpret_cast<unsigned char*>(output));
+    }
+
+    DmxStringValue buffer(worstCase, '\0');
+    size_t length = encodeString(input, text.size(), options, reinterpret_cast<unsigned char*>(&buffer[0]));
+    checkCapacity(length, outputCapacity);
+    memcpy(output, buffer.data(), length);
+    return length;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SortKeyUtil::doubleKey(double value, unsigned options, char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// 8 byte key of a double
+//
+    checkOptions(options, NUMERIC_OPTIONS);
+    checkCapacity(NUMERIC_KEY_LENGTH, outputCapacity);
+
+    unsigned char flip = (options & SORTKEY_DESCENDING) ? 0xFF : 0x00;
+    storeBigEndian(orderedDoubleBits(value), flip, reinterpret_cast<unsigned char*>(output), NUMERIC_KEY_LENGTH);
+    return NUMERIC_KEY_LENGTH;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SortKeyUtil::intKey(long long value, unsigned options, char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// 8 byte key of an integer
+//
+    checkOptions(options, NUMERIC_OPTIONS);
+    checkCapacity(NUMERIC_KEY_LENGTH, outputCapacity);
+
+    unsigned char flip = (options & SORTKEY_DESCENDING) ? 0xFF : 0x00;
+    uint64_t bits = static_cast<uint64_t>(value) ^ 0x8000000000000000ULL;
+    storeBigEndian(bits, flip, reinterpret_cast<unsigned char*>(output), NUMERIC_KEY_LENGTH);
+    return NUMERIC_KEY_LENGTH;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SortKeyUtil::dateTimeKey(const struct tm &dateTime, double fractionalSecond, unsigned options,
+                                char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// 17 byte key of a date time: 4 byte year, one byte per field below it, then
+// the fractional second as a double key; fields must be in their ranges for
+// the key to keep the order
+//
+    checkOptions(options, NUMERIC_OPTIONS);
+    checkCapacity(DATE_TIME_KEY_LENGTH, outputCapacity);
+
+    if (dateTime.tm_mon < 0 || dateTime.tm_mon > 11 || dateTime.tm_mday < 1 || dateTime.tm_mday > 31
+        || dateTime.tm_hour < 0 || dateTime.tm_hour > 23 || dateTime.tm_min < 0 || dateTime.tm_min > 59
+        || dateTime.tm_sec < 0 || dateTime.tm_sec > 60 || !(fractionalSecond >= 0 && fractionalSecond < 1)) {
+        throw std::invalid_argument("date time field out of range");
+    }
+
+    unsigned char flip = (options & SORTKEY_DESCENDING) ? 0xFF : 0x00;
+    unsigned char* key = reinterpret_cast<unsigned char*>(output);
+    storeBigEndian(static_cast<uint32_t>(dateTime.tm_year) ^ 0x80000000u, flip, key, 4);
+    key[4] = static_cast<unsigned char>(dateTime.tm_mon) ^ flip;
+    key[5] = static_cast<unsigned char>(dateTime.tm_mday) ^ flip;
+    key[6] = static_cast<unsigned char>(dateTime.tm_hour) ^ flip;
+    key[7] = static_cast<unsigned char>(dateTime.tm_min) ^ flip;
+    key[8] = static_cast<unsigned char>(dateTime.tm_sec) ^ flip;
+    storeBigEndian(orderedDoubleBits(fractionalSecond), flip, key + 9, NUMERIC_KEY_LENGTH);
+    return DATE_TIME_KEY_LENGTH;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SortKeyUtil::concatKeys(const DmxStringValue* const* keyPtrs, size_t numKeys, char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// tuple key from field keys; NULL pointers are null fields
+//
+    size_t length = 0;
+    for (size_t i = 0; i < numKeys; i++) {
+        length += 1 + ((keyPtrs[i] != NULL) ? keyPtrs[i]->size() : 0);
+    }
+    checkCapacity(length, outputCapacity);
+
+    size_t o = 0;
+    for (size_t i = 0; i < numKeys; i++) {
+        if (keyPtrs[i] == NULL) {
+            output[o++] = static_cast<char>(FIELD_NULL);
+            continue;
+        }
+        output[o++] = static_cast<char>(FIELD_PRESENT);
+        memcpy(output + o, keyPtrs[i]->data(), keyPtrs[i]->size());
+        o += keyPtrs[i]->size();
+    }
+    return o;
+}
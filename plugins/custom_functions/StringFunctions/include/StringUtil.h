@@ -7,16 +7,81 @@
  *******************************************************************************/
 #include <string>
 #include <vector>
+#include "dmx_custom_functions.h"
 /******************************************************************************/
 /* Custom function return statuses */
 
+class SubstringSearcher
+{
+public:
+    // preprocess a needle: Two-Way factorization and last byte shift table
+    explicit SubstringSearcher(const DmxStringValue& needle);
+
+    // offset of the first occurrence at or after start, std::string::npos if none
+    size_t find(const char* haystack, size_t length, size_t start) const;
+
+    const DmxStringValue& needle() const { return m_needle; }
+
+private:
+    size_t findTwoWay(const unsigned char* haystack, size_t length, size_t start) const;
+
+    DmxStringValue m_needle;
+    size_t m_criticalPosition;      // start of the right half minus one
+    size_t m_period;
+    size_t m_memory;                // prefix known to match after a period shift, 0 if not periodic
+    size_t m_shift[256];            // 1 + last position of each byte in the needle, 0 if absent
+};
+
 class StringUtil
 {
 public:
+    // normalizeText flags
+    enum NormalizeFlags {
+        NORMALIZE_UPPER                 = 1,
+        NORMALIZE_LOWER                 = 2,
+        NORMALIZE_TRIM                  = 4,
+        NORMALIZE_COLLAPSE_WHITESPACE   = 8
+    };
+
     // reverse a string
-    static std::string stringReverse(const std::string& text);
+    static DmxStringValue stringReverse(const DmxStringValue& text);
     // most frequent word with count
-    static std::string frequentWord(const std::string& text);
+    static DmxStringValue frequentWord(const DmxStringValue& text);
+
+    // Levenshtein edit distance between two strings
+    static long long levenshtein(const DmxStringValue& first, const DmxStringValue& second);
+    // Levenshtein edit distance, or maxDistance + 1 as soon as it is known to exceed maxDistance
+    static long long boundedLevenshtein(const DmxStringValue& first, const DmxStringValue& second, long long maxDistance);
+    // Jaro-Winkler similarity in [0, 1]
+    static double jaroWinkler(const DmxStringValue& first, const DmxStringValue& second);
+
+    // case mapping, trimming and whitespace collapsing in one pass; case mapping
+    // can lengthen a two byte UTF-8 character to three bytes. Writes at most
+    // outputCapacity bytes and returns the output length
+    static size_t normalizeText(const DmxStringValue& text, unsigned flags, char* output, size_t outputCapacity);
+
+    // character class shape: A upper, a lower, 9 digit, space for whitespace, U non-ASCII,
+    // other characters as they are, runs as symbol{length}; "AB-12" gives "A{2}-9{2}";
+    // literal {, } and \ are escaped with a backslash, "a{9}" gives "a\{9\}";
+    // writes at most outputCapacity bytes and returns the output length
+    static size_t profileString(const DmxStringValue& text, char* output, size_t outputCapacity);
+    // length, alpha, digit, space, other and nonascii counts as a JSON object; same output contract
+    static size_t profileCounts(const DmxStringValue& text, char* output, size_t outputCapacity);
+
+    // preprocessed needle, cached per thread since the pattern rarely changes across rows
+    static const SubstringSearcher& searcher(const DmxStringValue& pattern);
+    // true if pattern occurs in text
+    static bool contains(const DmxStringValue& text, const SubstringSearcher& needle);
+    static bool contains(const DmxStringValue& text, const DmxStringValue& pattern);
+    // 1-based position of the first occurrence, 0 if none
+    static long long indexOf(const DmxStringValue& text, const SubstringSearcher& needle);
+    static long long indexOf(const DmxStringValue& text, const DmxStringValue& pattern);
+    // number of non-overlapping occurrences
+    static long long countOccurrences(const DmxStringValue& text, const SubstringSearcher& needle);
+    static long long countOccurrences(const DmxStringValue& text, const DmxStringValue& pattern);
+    // replace every non-overlapping occurrence, left to right
+    static DmxStringValue replaceAll(const DmxStringValue& text, const SubstringSearcher& needle, const DmxStringValue& replacement);
+    static DmxStringValue replaceAll(const DmxStringValue& text, const DmxStringValue& pattern, const DmxStringValue& replacement);
 };
 
 #endif /* StringUtil_h */
@@ -0,0 +1,43 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "StringUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(Levenshtein, DMX_INT(distance), DMX_STRING(first), DMX_STRING(second)) {
+
+    if (first.isNull() || second.isNull()) {
+        distance.setNull();
+    }
+    else {
+        // edit distance
+        distance = StringUtil::levenshtein(first, second);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(BoundedLevenshtein, DMX_INT(distance), DMX_STRING(first), DMX_STRING(second), DMX_INT(maxDistance)) {
+
+    if (first.isNull() || second.isNull() || maxDistance.isNull()) {
+        distance.setNull();
+    }
+    else {
+        // edit distance, maxDistance + 1 once the bound is exceeded
+        distance = StringUtil::boundedLevenshtein(first, second, maxDistance);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(JaroWinkler, DMX_DOUBLE(similarity), DMX_STRING(first), DMX_STRING(second)) {
+
+    if (first.isNull() || second.isNull()) {
+        similarity.setNull();
+    }
+    else {
+        // Jaro-Winkler similarity
+        similarity = StringUtil::jaroWinkler(first, second);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
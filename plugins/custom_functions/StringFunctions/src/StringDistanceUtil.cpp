@@ -0,0 +1,327 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include "StringUtil.h"
+
+/******************************************************************************/
+
+/* Distance bound used internally to request an exact, unbounded distance */
+static const long long UNBOUNDED_DISTANCE = -1;
+
+/* Winkler prefix boost parameters */
+static const size_t JARO_WINKLER_MAX_PREFIX = 4;
+static const double JARO_WINKLER_PREFIX_SCALE = 0.1;
+static const double JARO_WINKLER_BOOST_THRESHOLD = 0.7;
+
+/* Scratch vectors sized by the input, on the host memory callbacks */
+typedef std::vector<uint64_t, DmxAllocator<uint64_t> > WordVector;
+typedef std::vector<bool, DmxAllocator<bool> > MatchFlags;
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool exceedsBound(long long score, size_t remaining, long long maxDistance) {
+//
+//Purpose
+//-------
+// true when the final distance can no longer be within maxDistance: every
+// remaining text character lowers the last-row score by at most one
+//
+    return maxDistance != UNBOUNDED_DISTANCE && score - static_cast<long long>(remaining) > maxDistance;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static long long myersSingleWord(const unsigned char* pattern, size_t m,
+                                 const unsigned char* text, size_t n,
+                                 long long maxDistance) {
+//
+//Purpose
+//-------
+// Myers/Hyyro bit-parallel edit distance for a pattern of 1..64 characters;
+// one column of the DP matrix is encoded in the VP/VN delta vectors
+//
+    uint64_t peq[256];
+    memset(peq, 0, sizeof(peq));
+    for (size_t i = 0; i < m; i++) {
+        peq[pattern[i]] |= static_cast<uint64_t>(1) << i;
+    }
+
+    const uint64_t last = static_cast<uint64_t>(1) << (m - 1);
+    uint64_t vp = ~static_cast<uint64_t>(0);
+    uint64_t vn = 0;
+    long long score = static_cast<long long>(m);
+
+    for (size_t j = 0; j < n; j++) {
+        uint64_t x = peq[text[j]] | vn;
+        uint64_t d0 = (((x & vp) + vp) ^ vp) | x;
+        uint64_t hp = vn | ~(d0 | vp);
+        uint64_t hn = d0 & vp;
+
+        if (hp & last) {
+            score++;
+        } else if (hn & last) {
+            score--;
+        }
+
+        hp = (hp << 1) | 1;
+        hn = hn << 1;
+        vp = hn | ~(d0 | hp);
+        vn = hp & d0;
+
+        if (exceedsBound(score, n - j - 1, maxDistance)) {
+            return maxDistance + 1;
+        }
+    }
+
+    return score;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static long long myersBlocked(const unsigned char* pattern, size_t m,
+                              const unsigned char* text, size_t n,
+                              long long maxDistance) {
+//
+//Purpose
+//-------
+// Myers (1999) block variant for patterns longer than 64 characters: the
+// pattern is split into 64-bit words and the horizontal deltas are carried
+// from one word to the next
+//
+    const size_t words = (m + 63) / 64;
+
+    /* match vectors stored character-major so one text character touches contiguous words */
+    WordVector peq(256 * words, 0);
+    for (size_t i = 0; i < m; i++) {
+        peq[pattern[i] * words + i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+    }
+
+    WordVector vp(words, ~static_cast<uint64_t>(0));
+    WordVector vn(words, 0);
+    const uint64_t last = static_cast<uint64_t>(1) << ((m - 1) % 64);
+    long long score = static_cast<long long>(m);
+
+    for (size_t j = 0; j < n; j++) {
+        const uint64_t* peqColumn = &peq[text[j] * words];
+        uint64_t hpCarry = 1;
+        uint64_t hnCarry = 0;
+
+        for (size_t w = 0; w < words; w++) {
+            uint64_t x = peqColumn[w] | hnCarry;
+            uint64_t d0 = (((x & vp[w]) + vp[w]) ^ vp[w]) | x | vn[w];
+            uint64_t hp = vn[w] | ~(d0 | vp[w]);
+            uint64_t hn = d0 & vp[w];
+
+            uint64_t hpOut;
+            uint64_t hnOut;
+            if (w + 1 < words) {
+                hpOut = hp >> 63;
+                hnOut = hn >> 63;
+            } else {
+                hpOut = (hp & last) ? 1 : 0;
+                hnOut = (hn & last) ? 1 : 0;
+            }
+
+            hp = (hp << 1) | hpCarry;
+            hn = (hn << 1) | hnCarry;
+            vp[w] = hn | ~(d0 | hp);
+            vn[w] = hp & d0;
+
+            hpCarry = hpOut;
+            hnCarry = hnOut;
+        }
+
+        score += static_cast<long long>(hpCarry) - static_cast<long long>(hnCarry);
+
+        if (exceedsBound(score, n - j - 1, maxDistance)) {
+            return maxDistance + 1;
+        }
+    }
+
+    return score;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static long long editDistance(const DmxStringValue& first, const DmxStringValue& second, long long maxDistance) {
+//
+//Purpose
+//-------
+// strip the common affixes, then run the bit-parallel kernel with the shorter
+// string as the pattern
+//
+    const DmxStringValue& shorter = (first.size() <= second.size()) ? first : second;
+    const DmxStringValue& longer = (first.size() <= second.size()) ? second : first;
+
+    /* the length difference is a lower bound of the distance */
+    if (maxDistance != UNBOUNDED_DISTANCE && static_cast<long long>(longer.size() - shorter.size()) > maxDistance) {
+        return maxDistance + 1;
+    }
+
+    const unsigned char* pattern = reinterpret_cast<const unsigned char*>(shorter.data());
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(longer.data());
+    size_t m = shorter.size();
+    size_t n = longer.size();
+
+    while (m > 0 && *pattern == *text) {
+        pattern++;
+        text++;
+        m--;
+        n--;
+    }
+    while (m > 0 && pattern[m - 1] == text[n - 1]) {
+        m--;
+        n--;
+    }
+
+    if (m == 0) {
+        return static_cast<long long>(n);
+    }
+    if (m <= 64) {
+        return myersSingleWord(pattern, m, text, n, maxDistance);
+    }
+    return myersBlocked(pattern, m, text, n, maxDistance);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long StringUtil::levenshtein(const DmxStringValue &first, const DmxStringValue &second) {
+//
+//Purpose
+//-------
+// Levenshtein edit distance (insertions, deletions, substitutions) in bytes
+//
+    return editDistance(first, second, UNBOUNDED_DISTANCE);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long StringUtil::boundedLevenshtein(const DmxStringValue &first, const DmxStringValue &second, long long maxDistance) {
+//
+//Purpose
+//-------
+// Levenshtein edit distance if it is at most maxDistance, otherwise
+// maxDistance + 1; stops scanning as soon as the bound is exceeded
+//
+    if (maxDistance < 0) {
+        throw std::invalid_argument("maximum distance must not be negative");
+    }
+    return editDistance(first, second, maxDistance);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t jaroMatchesBitParallel(const DmxStringValue& first, const DmxStringValue& second, size_t window,
+                                     MatchFlags& firstFlags, uint64_t& secondFlags) {
+//
+//Purpose
+//-------
+// Jaro matching step when the second string fits in one 64-bit word: the
+// candidate positions for each character are found with one mask operation
+//
+    uint64_t peq[256];
+    memset(peq, 0, sizeof(peq));
+    for (size_t j = 0; j < second.size(); j++) {
+        peq[static_cast<unsigned char>(second[j])] |= static_cast<uint64_t>(1) << j;
+    }
+
+    size_t matches = 0;
+    secondFlags = 0;
+
+    for (size_t i = 0; i < first.size(); i++) {
+        size_t lo = (i > window) ? i - window : 0;
+        size_t hi = std::min(i + window + 1, second.size());
+        if (lo >= hi) {
+            continue;
+        }
+        uint64_t windowMask = (hi == 64) ? ~static_cast<uint64_t>(0) : ((static_cast<uint64_t>(1) << hi) - 1);
+        windowMask &= ~((static_cast<uint64_t>(1) << lo) - 1);
+
+        uint64_t candidates = peq[static_cast<unsigned char>(first[i])] & windowMask & ~secondFlags;
+        if (candidates != 0) {
+            secondFlags |= candidates & (~candidates + 1);
+            firstFlags[i] = true;
+            matches++;
+        }
+    }
+
+    return matches;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+double StringUtil::jaroWinkler(const DmxStringValue &first, const DmxStringValue &second) {
+//
+//Purpose
+//-------
+// Jaro-Winkler similarity: 1 for identical strings, 0 for no common characters
+//
+    if (first.empty() && second.empty()) {
+        return 1.0;
+    }
+    if (first.empty() || second.empty()) {
+        return 0.0;
+    }
+
+    size_t longest = std::max(first.size(), second.size());
+    size_t window = (longest / 2 > 0) ? longest / 2 - 1 : 0;
+
+    MatchFlags firstFlags(first.size(), false);
+    MatchFlags secondFlags(second.size(), false);
+    size_t matches = 0;
+
+    if (second.size() <= 64) {
+        uint64_t secondMask;
+        matches = jaroMatchesBitParallel(first, second, window, firstFlags, secondMask);
+        for (size_t j = 0; j < second.size(); j++) {
+            secondFlags[j] = ((secondMask >> j) & 1) != 0;
+        }
+    } else {
+        for (size_t i = 0; i < first.size(); i++) {
+            size_t lo = (i > window) ? i - window : 0;
+            size_t hi = std::min(i + window + 1, second.size());
+            for (size_t j = lo; j < hi; j++) {
+                if (!secondFlags[j] && first[i] == second[j]) {
+                    firstFlags[i] = true;
+                    secondFlags[j] = true;
+                    matches++;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (matches == 0) {
+        return 0.0;
+    }
+
+    /* count matched characters that appear in a different order */
+    size_t transpositions = 0;
+    for (size_t i = 0, j = 0; i < first.size(); i++) {
+        if (!firstFlags[i]) {
+            continue;
+        }
+        while (!secondFlags[j]) {
+            j++;
+        }
+        if (first[i] != second[j]) {
+            transpositions++;
+        }
+        j++;
+    }
+
+    double m = static_cast<double>(matches);
+    double jaro = (m / first.size() + m / second.size() + (m - transpositions / 2) / m) / 3.0;
+
+    if (jaro <= JARO_WINKLER_BOOST_THRESHOLD) {
+        return jaro;
+    }
+
+    size_t prefix = 0;
+    size_t maxPrefix = std::min(JARO_WINKLER_MAX_PREFIX, std::min(first.size(), second.size()));
+    while (prefix < maxPrefix && first[prefix] == second[prefix]) {
+        prefix++;
+    }
+
+    return jaro + prefix * JARO_WINKLER_PREFIX_SCALE * (1.0 - jaro);
+}
@@ -2,6 +2,7 @@
 #include "dmx_custom_functions.h"
 #include "StringUtil.h"
 #include <vector>
+#include <algorithm>
 
 DMX_CUSTOM_FUNCTION(StringReverse, DMX_STRING(text), DMX_STRING(input)) {
 
@@ -28,3 +29,21 @@ DMX_CUSTOM_FUNCTION(FrequentWord, DMX_STRING(text), DMX_STRING(input)) {
 
     return DMX_CUSTOM_FUNCTION_SUCCESS;
 }
+
+/* Streaming StringReverse: chunks arrive from the end of the value, each one
+   is written back to front */
+class StringReverseStream : public DmxStreamFunction
+{
+public:
+    void processChunk(const char* dataPtr, size_t size, DmxStreamWriter& writer) {
+        while (size != 0) {
+            size_t count = writer.reserve(1);
+            count = (count < size) ? count : size;
+            std::reverse_copy(dataPtr + size - count, dataPtr + size, writer.getData());
+            writer.commit(count);
+            size -= count;
+        }
+    }
+};
+
+DMX_CUSTOM_STREAM_FUNCTION(StringReverse, StringReverseStream, DMX_STREAM_REVERSE)
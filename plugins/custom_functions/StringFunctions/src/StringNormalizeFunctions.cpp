@@ -0,0 +1,52 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "StringUtil.h"
+
+
+/* Normalization helper: writes straight into the output buffer */
+static int normalizeInto(DmxString& text, const DmxString& input, unsigned flags) {
+
+    if (input.isNull()) {
+        text.setNull();
+    }
+    else {
+        text.setOutputLength(StringUtil::normalizeText(input, flags, text.getOutputData(), text.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(Upper, DMX_STRING(text), DMX_STRING(input)) {
+
+    // upper case (Unicode simple case mapping)
+    return normalizeInto(text, input, StringUtil::NORMALIZE_UPPER);
+}
+
+DMX_CUSTOM_FUNCTION(Lower, DMX_STRING(text), DMX_STRING(input)) {
+
+    // lower case (Unicode simple case mapping)
+    return normalizeInto(text, input, StringUtil::NORMALIZE_LOWER);
+}
+
+DMX_CUSTOM_FUNCTION(Trim, DMX_STRING(text), DMX_STRING(input)) {
+
+    // remove leading and trailing whitespace
+    return normalizeInto(text, input, StringUtil::NORMALIZE_TRIM);
+}
+
+DMX_CUSTOM_FUNCTION(CollapseWhitespace, DMX_STRING(text), DMX_STRING(input)) {
+
+    // replace each whitespace run by a single space
+    return normalizeInto(text, input, StringUtil::NORMALIZE_COLLAPSE_WHITESPACE);
+}
+
+DMX_CUSTOM_FUNCTION(NormalizeText, DMX_STRING(text), DMX_STRING(input), DMX_INT(flags)) {
+
+    if (flags.isNull()) {
+        text.setNull();
+        return DMX_CUSTOM_FUNCTION_SUCCESS;
+    }
+
+    // flags: 1 upper, 2 lower, 4 trim, 8 collapse whitespace
+    return normalizeInto(text, input, static_cast<unsigned>(static_cast<long long>(flags)));
+}
@@ -0,0 +1,30 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "StringUtil.h"
+
+
+DMX_CUSTOM_FUNCTION(ProfileString, DMX_STRING(shape), DMX_STRING(input)) {
+
+    if (input.isNull()) {
+        shape.setNull();
+    }
+    else {
+        // character class shape, written straight into the output buffer
+        shape.setOutputLength(StringUtil::profileString(input, shape.getOutputData(), shape.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION(ProfileCounts, DMX_STRING(counts), DMX_STRING(input)) {
+
+    if (input.isNull()) {
+        counts.setNull();
+    }
+    else {
+        // class counts as a JSON object, written straight into the output buffer
+        counts.setOutputLength(StringUtil::profileCounts(input, counts.getOutputData(), counts.getOutputCapacity()));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
@@ -0,0 +1,439 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <stdint.h>
+#include "StringUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+static const size_t BLOCK_SIZE = 32;
+
+/* Class bits of the nibble lookup: a byte is in a class when the class bit is
+   set both in the entry of its low nibble and in the entry of its high nibble */
+enum ClassBits {
+    CLASS_LETTER_LOW    = 0x01,     // 0x41..0x4F, 0x61..0x6F
+    CLASS_LETTER_HIGH   = 0x02,     // 0x50..0x5A, 0x70..0x7A
+    CLASS_DIGIT         = 0x04,     // 0x30..0x39
+    CLASS_SPACE         = 0x08,     // 0x20
+    CLASS_CONTROL_SPACE = 0x10,     // 0x09..0x0D
+    CLASS_CONTINUATION  = 0x40      // 0x80..0xBF
+};
+
+static const unsigned char LOW_NIBBLE_CLASSES[16] = {
+    0x4E, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47,
+    0x47, 0x57, 0x53, 0x51, 0x51, 0x51, 0x41, 0x41
+};
+
+static const unsigned char HIGH_NIBBLE_CLASSES[16] = {
+    0x10, 0x00, 0x08, 0x04, 0x01, 0x02, 0x01, 0x02,
+    0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00
+};
+
+/* Character classes of one block, one bit per byte, and the shape symbol of
+   every byte; bytes in none of the classes are other ASCII characters, kept as
+   they are in a shape */
+struct ProfileBlock {
+    uint32_t alpha;
+    uint32_t digit;
+    uint32_t space;
+    uint32_t high;                  // bytes 0x80..0xFF
+    uint32_t continuation;          // bytes 0x80..0xBF
+    uint32_t sameSymbol;            // symbol equal to the one before it
+    unsigned char symbols[BLOCK_SIZE];
+};
+
+/* Shape symbols of the classes */
+static const char SHAPE_UPPER = 'A';
+static const char SHAPE_LOWER = 'a';
+static const char SHAPE_DIGIT = '9';
+static const char SHAPE_SPACE = ' ';
+static const char SHAPE_NON_ASCII = 'U';
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline unsigned popCount(uint32_t bits) {
+//
+//Purpose
+//-------
+// number of set bits; without POPCNT in the baseline instruction set the
+// builtin is a library call, slower than the bit parallel sum
+//
+#if defined(__GNUC__) && defined(__POPCNT__)
+    return static_cast<unsigned>(__builtin_popcount(bits));
+#else
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0Fu;
+    return (bits * 0x01010101u) >> 24;
+#endif
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline unsigned lowestBit(uint32_t bits) {
+//
+//Purpose
+//-------
+// index of the lowest set bit, bits is not 0
+//
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(bits));
+#else
+    unsigned index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t bitRange(unsigned begin, unsigned end) {
+//
+//Purpose
+//-------
+// bits [begin, end) of a block mask
+//
+    return static_cast<uint32_t>(((static_cast<uint64_t>(1) << end) - 1) & ~((static_cast<uint64_t>(1) << begin) - 1));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void classifyScalar(const unsigned char* block, unsigned char& previousSymbol, ProfileBlock& classes) {
+//
+//Purpose
+//-------
+// the nibble lookup one byte at a time
+//
+    memset(&classes, 0, offsetof(ProfileBlock, symbols));
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        uint32_t bit = static_cast<uint32_t>(1) << i;
+        unsigned char c = block[i];
+        unsigned bits = LOW_NIBBLE_CLASSES[c & 0x0F] & HIGH_NIBBLE_CLASSES[c >> 4];
+        unsigned char symbol = c;
+        if (bits & (CLASS_LETTER_LOW | CLASS_LETTER_HIGH)) {
+            classes.alpha |= bit;
+            symbol = (c & 0x20) ? SHAPE_LOWER : SHAPE_UPPER;
+        } else if (bits & CLASS_DIGIT) {
+            classes.digit |= bit;
+            symbol = SHAPE_DIGIT;
+        } else if (bits & (CLASS_SPACE | CLASS_CONTROL_SPACE)) {
+            classes.space |= bit;
+            symbol = SHAPE_SPACE;
+        } else if (c & 0x80) {
+            classes.high |= bit;
+            if (bits & CLASS_CONTINUATION) {
+                classes.continuation |= bit;
+            }
+            symbol = SHAPE_NON_ASCII;
+        }
+        if (symbol == previousSymbol) {
+            classes.sameSymbol |= bit;
+        }
+        classes.symbols[i] = symbol;
+        previousSymbol = symbol;
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static inline __m256i anyBitAvx2(__m256i bits, unsigned char selected) {
+//
+//Purpose
+//-------
+// all ones in the bytes with any of the selected class bits set
+//
+    __m256i zero = _mm256_setzero_si256();
+    return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_and_si256(bits, _mm256_set1_epi8(static_cast<char>(selected))), zero),
+                            _mm256_cmpeq_epi8(zero, zero));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static inline void classifyAvx2(const unsigned char* block, __m256i& previousSymbols, ProfileBlock& classes) {
+//
+//Purpose
+//-------
+// 32 bytes at once: two pshufb nibble lookups and an and give the class bits
+// of every byte, blends give the symbols; previousSymbols carries the last
+// block's symbols for the comparison with the symbol before each byte
+//
+    const __m256i lowTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(LOW_NIBBLE_CLASSES)));
+    const __m256i highTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(HIGH_NIBBLE_CLASSES)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i lowNibbles = _mm256_and_si256(bytes, nibble);
+    __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+    __m256i bits = _mm256_and_si256(_mm256_shuffle_epi8(lowTable, lowNibbles),
+                                    _mm256_shuffle_epi8(highTable, highNibbles));
+
+    __m256i alpha = anyBitAvx2(bits, CLASS_LETTER_LOW | CLASS_LETTER_HIGH);
+    __m256i digit = anyBitAvx2(bits, CLASS_DIGIT);
+    __m256i space = anyBitAvx2(bits, CLASS_SPACE | CLASS_CONTROL_SPACE);
+    __m256i lowerCase = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, caseBit), caseBit);
+
+    /* bytes 0x80..0xFF are the only ones with the sign bit, blendv tests it */
+    __m256i symbols = _mm256_blendv_epi8(bytes, _mm256_set1_epi8(SHAPE_NON_ASCII), bytes);
+    symbols = _mm256_blendv_epi8(symbols, _mm256_set1_epi8(SHAPE_SPACE), space);
+    symbols = _mm256_blendv_epi8(symbols, _mm256_set1_epi8(SHAPE_DIGIT), digit);
+    symbols = _mm256_blendv_epi8(symbols, _mm256_blendv_epi8(_mm256_set1_epi8(SHAPE_UPPER), _mm256_set1_epi8(SHAPE_LOWER), lowerCase), alpha);
+
+    /* symbols shifted by one byte across the lanes, the last block's symbol first */
+    __m256i shifted = _mm256_alignr_epi8(symbols, _mm256_permute2x128_si256(previousSymbols, symbols, 0x21), 15);
+
+    classes.alpha = static_cast<uint32_t>(_mm256_movemask_epi8(alpha));
+    classes.digit = static_cast<uint32_t>(_mm256_movemask_epi8(digit));
+    classes.space = static_cast<uint32_t>(_mm256_movemask_epi8(space));
+    classes.high = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+    classes.continuation = static_cast<uint32_t>(_mm256_movemask_epi8(anyBitAvx2(bits, CLASS_CONTINUATION)));
+    classes.sameSymbol = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(symbols, shifted)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(classes.symbols), symbols);
+    previousSymbols = symbols;
+}
+#endif
+
+/* Bounded output: a result longer than the buffer is truncated */
+class ProfileWriter
+{
+public:
+    ProfileWriter(char* output, size_t capacity) : m_output(output), m_capacity(capacity), m_length(0) {}
+
+    void append(char c) {
+        if (m_length < m_capacity) {
+            m_output[m_length++] = c;
+        }
+    }
+    void append(const char* text, size_t length) {
+        if (length > m_capacity - m_length) {
+            length = m_capacity - m_length;
+        }
+        memcpy(m_output + m_length, text, length);
+        m_length += length;
+    }
+    size_t length() const { return m_length; }
+
+private:
+    char* m_output;
+    size_t m_capacity;
+    size_t m_length;
+};
+
+/* Class totals and the open shape run, carried across blocks */
+struct ProfileState {
+    size_t alpha;
+    size_t digit;
+    size_t space;
+    size_t other;
+    size_t nonAscii;                // characters, a UTF-8 sequence counts once
+    uint32_t carryHigh;             // 1 if the last block ended with a byte 0x80..0xFF
+    char runSymbol;
+    size_t runCount;
+    bool isRunOpen;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static void appendRun(ProfileWriter& writer, char symbol, size_t count) {
+//
+//Purpose
+//-------
+// symbol, then {count} for runs longer than one; a literal brace or
+// backslash is escaped with a backslash so it cannot read as a run length
+//
+    if (symbol == '{' || symbol == '}' || symbol == '\\') {
+        writer.append('\\');
+    }
+    writer.append(symbol);
+    if (count > 1) {
+        char digits[24];
+        char* digitPtr = digits + sizeof(digits);
+        *--digitPtr = '}';
+        for (; count != 0; count /= 10) {
+            *--digitPtr = static_cast<char>('0' + count % 10);
+        }
+        *--digitPtr = '{';
+        writer.append(digitPtr, static_cast<size_t>(digits + sizeof(digits) - digitPtr));
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline uint32_t countBlock(const ProfileBlock& classes, size_t blockLength, ProfileState& state) {
+//
+//Purpose
+//-------
+// add up the classes; returns the bytes that start a character; continuation
+// bytes after a non-ASCII byte belong to its character
+//
+    uint32_t valid = bitRange(0, static_cast<unsigned>(blockLength));
+    uint32_t other = valid & ~(classes.alpha | classes.digit | classes.space | classes.high);
+    uint32_t counted = valid & ~(classes.continuation & ((classes.high << 1) | state.carryHigh));
+
+    state.alpha += popCount(classes.alpha & valid);
+    state.digit += popCount(classes.digit & valid);
+    state.space += popCount(classes.space & valid);
+    state.other += popCount(other);
+    state.nonAscii += popCount(classes.high & counted);
+    state.carryHigh = classes.high >> 31;
+    return counted;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void shapeBlock(const ProfileBlock& classes, size_t blockLength, uint32_t counted,
+                       ProfileState& state, ProfileWriter& writer) {
+//
+//Purpose
+//-------
+// write the runs of equal symbols that end in the block, a run counts the
+// characters it holds
+//
+    uint32_t boundaries = bitRange(0, static_cast<unsigned>(blockLength)) & ~classes.sameSymbol;
+    if (!state.isRunOpen) {
+        boundaries |= 1;
+    }
+    unsigned runStart = 0;
+    while (boundaries != 0) {
+        unsigned position = lowestBit(boundaries);
+        boundaries &= boundaries - 1;
+        if (state.isRunOpen) {
+            appendRun(writer, state.runSymbol, state.runCount + popCount(counted & bitRange(runStart, position)));
+        }
+        state.runSymbol = static_cast<char>(classes.symbols[position]);
+        state.runCount = 0;
+        state.isRunOpen = true;
+        runStart = position;
+    }
+    state.runCount += popCount(counted & bitRange(runStart, static_cast<unsigned>(blockLength)));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static inline const unsigned char* blockAt(const unsigned char* text, size_t length, size_t offset,
+                                           unsigned char padded[BLOCK_SIZE], size_t& blockLength) {
+//
+//Purpose
+//-------
+// the block at offset, the last one copied into a zero padded buffer
+//
+    if (length - offset >= BLOCK_SIZE) {
+        blockLength = BLOCK_SIZE;
+        return text + offset;
+    }
+    blockLength = length - offset;
+    memset(padded, 0, BLOCK_SIZE);
+    memcpy(padded, text + offset, blockLength);
+    return padded;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void profileScalar(const unsigned char* text, size_t length, ProfileState& state, ProfileWriter* shapePtr) {
+//
+//Purpose
+//-------
+// all blocks with the scalar classifier
+//
+    unsigned char padded[BLOCK_SIZE];
+    unsigned char previousSymbol = 0;
+    ProfileBlock classes;
+    for (size_t offset = 0; offset < length; offset += BLOCK_SIZE) {
+        size_t blockLength;
+        const unsigned char* block = blockAt(text, length, offset, padded, blockLength);
+        classifyScalar(block, previousSymbol, classes);
+        uint32_t counted = countBlock(classes, blockLength, state);
+        if (shapePtr != NULL) {
+            shapeBlock(classes, blockLength, counted, state, *shapePtr);
+        }
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static void profileAvx2(const unsigned char* text, size_t length, ProfileState& state, ProfileWriter* shapePtr) {
+//
+//Purpose
+//-------
+// all blocks with the AVX2 classifier
+//
+    unsigned char padded[BLOCK_SIZE];
+    __m256i previousSymbols = _mm256_setzero_si256();
+    ProfileBlock classes;
+    for (size_t offset = 0; offset < length; offset += BLOCK_SIZE) {
+        size_t blockLength;
+        const unsigned char* block = blockAt(text, length, offset, padded, blockLength);
+        classifyAvx2(block, previousSymbols, classes);
+        uint32_t counted = countBlock(classes, blockLength, state);
+        if (shapePtr != NULL) {
+            shapeBlock(classes, blockLength, counted, state, *shapePtr);
+        }
+    }
+}
+#endif
+
+/****************************** MEMBER FUNCTION *******************************/
+static void profile(const unsigned char* text, size_t length, ProfileState& state, ProfileWriter* shapePtr) {
+//
+//Purpose
+//-------
+// classify 32 bytes at a time, add up the classes and, with a writer, write
+// the shape: a run ends where the symbol changes, so runs of other characters
+// are runs of one character
+//
+    memset(&state, 0, sizeof(state));
+
+#if defined(DMX_SIMD_X86)
+    if (dmxCpuHasAvx2()) {
+        profileAvx2(text, length, state, shapePtr);
+    } else {
+        profileScalar(text, length, state, shapePtr);
+    }
+#else
+    profileScalar(text, length, state, shapePtr);
+#endif
+
+    if (shapePtr != NULL && state.isRunOpen) {
+        appendRun(*shapePtr, state.runSymbol, state.runCount);
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t StringUtil::profileString(const DmxStringValue &text, char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// character class shape into the output buffer; a result longer than the
+// buffer is truncated
+//
+    ProfileState state;
+    ProfileWriter writer(output, outputCapacity);
+    profile(reinterpret_cast<const unsigned char*>(text.data()), text.size(), state, &writer);
+    return writer.length();
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t StringUtil::profileCounts(const DmxStringValue &text, char* output, size_t outputCapacity) {
+//
+//Purpose
+//-------
+// class counts as a JSON object into the output buffer; a result longer than
+// the buffer is truncated
+//
+    ProfileState state;
+    profile(reinterpret_cast<const unsigned char*>(text.data()), text.size(), state, NULL);
+
+    char counts[256];
+    int length = snprintf(counts, sizeof(counts),
+                          "{\"length\":%lu,\"alpha\":%lu,\"digit\":%lu,\"space\":%lu,\"other\":%lu,\"nonascii\":%lu}",
+                          static_cast<unsigned long>(text.size()), static_cast<unsigned long>(state.alpha),
+                          static_cast<unsigned long>(state.digit), static_cast<unsigned long>(state.space),
+                          static_cast<unsigned long>(state.other), static_cast<unsigned long>(state.nonAscii));
+
+    ProfileWriter writer(output, outputCapacity);
+    writer.append(counts, static_cast<size_t>(length));
+    return writer.length();
+}
@@ -0,0 +1,87 @@
+#include <string>
+#include "dmx_custom_functions.h"
+#include "StringUtil.h"
+
+
+/* Prepared state: the pattern preprocessed once for the whole job */
+class SearcherState
+{
+public:
+    explicit SearcherState(void* const* argumentPtrs) : m_searcher(DmxString(argumentPtrs[2])) {}
+
+    const SubstringSearcher& searcher() const { return m_searcher; }
+
+private:
+    SubstringSearcher m_searcher;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static const SubstringSearcher& searcher(const DmxStringValue& pattern) {
+//
+//Purpose
+//-------
+// the prepared searcher if there is one, otherwise the per-thread cache
+//
+    const SearcherState* statePtr = dmxGetPreparedState<SearcherState>();
+    return (statePtr != NULL) ? statePtr->searcher() : StringUtil::searcher(pattern);
+}
+
+DMX_CUSTOM_FUNCTION(Contains, DMX_INT(found), DMX_STRING(input), DMX_STRING(pattern)) {
+
+    if (input.isNull() || pattern.isNull()) {
+        found.setNull();
+    }
+    else {
+        // 1 if pattern occurs in input, 0 otherwise
+        found = StringUtil::contains(input, searcher(pattern)) ? 1 : 0;
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(Contains, SearcherState, DMX_CONSTANT_ARGUMENT(2))
+
+DMX_CUSTOM_FUNCTION(IndexOf, DMX_INT(position), DMX_STRING(input), DMX_STRING(pattern)) {
+
+    if (input.isNull() || pattern.isNull()) {
+        position.setNull();
+    }
+    else {
+        // 1-based position of the first occurrence, 0 if none
+        position = StringUtil::indexOf(input, searcher(pattern));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(IndexOf, SearcherState, DMX_CONSTANT_ARGUMENT(2))
+
+DMX_CUSTOM_FUNCTION(CountOccurrences, DMX_INT(count), DMX_STRING(input), DMX_STRING(pattern)) {
+
+    if (input.isNull() || pattern.isNull()) {
+        count.setNull();
+    }
+    else {
+        // non-overlapping occurrences
+        count = StringUtil::countOccurrences(input, searcher(pattern));
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(CountOccurrences, SearcherState, DMX_CONSTANT_ARGUMENT(2))
+
+DMX_CUSTOM_FUNCTION(ReplaceAll, DMX_STRING(text), DMX_STRING(input), DMX_STRING(pattern), DMX_STRING(replacement)) {
+
+    if (input.isNull() || pattern.isNull() || replacement.isNull()) {
+        text.setNull();
+    }
+    else {
+        // replace every non-overlapping occurrence
+        text = StringUtil::replaceAll(input, searcher(pattern), replacement);
+    }
+
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+DMX_CUSTOM_FUNCTION_PREPARE(ReplaceAll, SearcherState, DMX_CONSTANT_ARGUMENT(2))
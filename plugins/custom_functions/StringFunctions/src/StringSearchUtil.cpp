@@ -0,0 +1,377 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+#include "StringUtil.h"
+#include "dmx_simd.h"
+
+/******************************************************************************/
+
+/* Needles up to this length use the vector first/last byte filter */
+static const size_t SHORT_NEEDLE_MAX = 32;
+
+/* Preprocessed needles kept per thread */
+static const size_t SEARCHER_CACHE_SIZE = 4;
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t maximalSuffix(const unsigned char* needle, size_t length, bool isReversed, size_t& period) {
+//
+//Purpose
+//-------
+// maximal suffix of the needle for the byte order (or its reverse), with its
+// period; returns the position before the suffix (size_t(-1) for the whole needle)
+//
+    size_t ip = static_cast<size_t>(-1);
+    size_t jp = 0;
+    size_t k = 1;
+    period = 1;
+
+    while (jp + k < length) {
+        unsigned char a = needle[ip + k];
+        unsigned char b = needle[jp + k];
+        if (a == b) {
+            if (k == period) {
+                jp += period;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (isReversed ? (a < b) : (a > b)) {
+            jp += k;
+            k = 1;
+            period = jp - ip;
+        } else {
+            ip = jp++;
+            k = period = 1;
+        }
+    }
+
+    return ip;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+SubstringSearcher::SubstringSearcher(const DmxStringValue& needle)
+: m_needle(needle),
+  m_criticalPosition(0),
+  m_period(1),
+  m_memory(0)
+{
+//
+//Purpose
+//-------
+// critical factorization (Crochemore-Perrin) and last byte shift table
+//
+    const unsigned char* n = reinterpret_cast<const unsigned char*>(m_needle.data());
+    size_t length = m_needle.size();
+
+    memset(m_shift, 0, sizeof(m_shift));
+    for (size_t i = 0; i < length; i++) {
+        m_shift[n[i]] = i + 1;
+    }
+
+    if (length < 2) {
+        return;
+    }
+
+    size_t period;
+    size_t reversedPeriod;
+    size_t position = maximalSuffix(n, length, false, period);
+    size_t reversedPosition = maximalSuffix(n, length, true, reversedPeriod);
+    if (reversedPosition + 1 > position + 1) {
+        position = reversedPosition;
+        period = reversedPeriod;
+    }
+    m_criticalPosition = position;
+
+    if (memcmp(n, n + period, position + 1) != 0) {
+        /* not periodic: any shift up to the longer half is safe */
+        m_period = std::max(position, length - position - 1) + 1;
+        m_memory = 0;
+    } else {
+        m_period = period;
+        m_memory = length - period;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SubstringSearcher::findTwoWay(const unsigned char* haystack, size_t length, size_t start) const {
+//
+//Purpose
+//-------
+// Two-Way search with a last byte skip; linear in the haystack length
+//
+    const unsigned char* n = reinterpret_cast<const unsigned char*>(m_needle.data());
+    const size_t l = m_needle.size();
+    const size_t ms = m_criticalPosition;
+    const unsigned char* h = haystack + start;
+    const unsigned char* z = haystack + length;
+    size_t memory = 0;
+
+    for (;;) {
+        if (static_cast<size_t>(z - h) < l) {
+            return std::string::npos;
+        }
+
+        size_t shift = m_shift[h[l - 1]];
+        if (shift == 0) {
+            h += l;
+            memory = 0;
+            continue;
+        }
+        if (shift != l) {
+            size_t k = std::max(l - shift, memory);
+            h += k;
+            memory = 0;
+            continue;
+        }
+
+        /* right half */
+        size_t k = std::max(ms + 1, memory);
+        while (k < l && n[k] == h[k]) {
+            k++;
+        }
+        if (k < l) {
+            h += k - ms;
+            memory = 0;
+            continue;
+        }
+
+        /* left half */
+        for (k = ms + 1; k > memory && n[k - 1] == h[k - 1]; k--) {
+        }
+        if (k <= memory) {
+            return static_cast<size_t>(h - haystack);
+        }
+        h += m_period;
+        memory = m_memory;
+    }
+}
+
+#if defined(DMX_SIMD_X86)
+/****************************** MEMBER FUNCTION *******************************/
+DMX_TARGET_AVX2
+static size_t findShortAvx2(const unsigned char* haystack, size_t length, size_t start,
+                            const unsigned char* needle, size_t needleLength) {
+//
+//Purpose
+//-------
+// compare the first and last needle bytes at 32 positions at once; only
+// positions matching both are verified
+//
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    const __m256i last = _mm256_set1_epi8(static_cast<char>(needle[needleLength - 1]));
+    size_t i = start;
+
+    for (; i + needleLength - 1 + 32 <= length; i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needleLength - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+        while (mask != 0) {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (memcmp(haystack + candidate + 1, needle + 1, needleLength - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    /* tail shorter than one block */
+    for (; i + needleLength <= length; i++) {
+        if (haystack[i] == needle[0] && memcmp(haystack + i + 1, needle + 1, needleLength - 1) == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+#endif
+
+/****************************** MEMBER FUNCTION *******************************/
+size_t SubstringSearcher::find(const char* haystack, size_t length, size_t start) const {
+//
+//Purpose
+//-------
+// pick the search kernel for the needle length
+//
+    const size_t needleLength = m_needle.size();
+
+    if (start > length || length - start < needleLength) {
+        return std::string::npos;
+    }
+    if (needleLength == 0) {
+        return start;
+    }
+    if (needleLength == 1) {
+        const void* match = memchr(haystack + start, m_needle[0], length - start);
+        return (match == NULL) ? std::string::npos : static_cast<size_t>(static_cast<const char*>(match) - haystack);
+    }
+
+    const unsigned char* h = reinterpret_cast<const unsigned char*>(haystack);
+#if defined(DMX_SIMD_X86)
+    if (needleLength <= SHORT_NEEDLE_MAX && dmxCpuHasAvx2()) {
+        return findShortAvx2(h, length, start, reinterpret_cast<const unsigned char*>(m_needle.data()), needleLength);
+    }
+#endif
+    return findTwoWay(h, length, start);
+}
+
+/******************************************************************************/
+
+/* Most recently used needles of the calling thread, on the host memory callbacks */
+struct SearcherCache {
+    SubstringSearcher* searchers[SEARCHER_CACHE_SIZE];
+    size_t next;
+
+    SearcherCache() : next(0) {
+        std::fill(searchers, searchers + SEARCHER_CACHE_SIZE, static_cast<SubstringSearcher*>(NULL));
+    }
+    ~SearcherCache() {
+        for (size_t i = 0; i < SEARCHER_CACHE_SIZE; i++) {
+            dmxDestroy(searchers[i]);
+        }
+    }
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+const SubstringSearcher& StringUtil::searcher(const DmxStringValue &pattern) {
+//
+//Purpose
+//-------
+// preprocessed needle from the per-thread cache, built on a miss
+//
+    static thread_local SearcherCache cache;
+
+    for (size_t i = 0; i < SEARCHER_CACHE_SIZE; i++) {
+        if (cache.searchers[i] != NULL && cache.searchers[i]->needle() == pattern) {
+            return *cache.searchers[i];
+        }
+    }
+
+    SubstringSearcher* created = dmxCreate<SubstringSearcher>(pattern);
+    dmxDestroy(cache.searchers[cache.next]);
+    cache.searchers[cache.next] = created;
+    cache.next = (cache.next + 1) % SEARCHER_CACHE_SIZE;
+    return *created;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool StringUtil::contains(const DmxStringValue &text, const SubstringSearcher &needle) {
+//
+//Purpose
+//-------
+// true if the needle occurs in text
+//
+    return needle.find(text.data(), text.size(), 0) != std::string::npos;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+bool StringUtil::contains(const DmxStringValue &text, const DmxStringValue &pattern) {
+//
+//Purpose
+//-------
+// true if pattern occurs in text
+//
+    return contains(text, searcher(pattern));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long StringUtil::indexOf(const DmxStringValue &text, const SubstringSearcher &needle) {
+//
+//Purpose
+//-------
+// 1-based position of the first occurrence, 0 if none
+//
+    size_t position = needle.find(text.data(), text.size(), 0);
+    return (position == std::string::npos) ? 0 : static_cast<long long>(position) + 1;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long StringUtil::indexOf(const DmxStringValue &text, const DmxStringValue &pattern) {
+//
+//Purpose
+//-------
+// indexOf with a cached searcher
+//
+    return indexOf(text, searcher(pattern));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long StringUtil::countOccurrences(const DmxStringValue &text, const SubstringSearcher &needle) {
+//
+//Purpose
+//-------
+// number of non-overlapping occurrences; 0 for an empty needle
+//
+    size_t length = needle.needle().size();
+    if (length == 0) {
+        return 0;
+    }
+
+    long long count = 0;
+    for (size_t position = needle.find(text.data(), text.size(), 0);
+         position != std::string::npos;
+         position = needle.find(text.data(), text.size(), position + length)) {
+        count++;
+    }
+    return count;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+long long StringUtil::countOccurrences(const DmxStringValue &text, const DmxStringValue &pattern) {
+//
+//Purpose
+//-------
+// countOccurrences with a cached searcher
+//
+    if (pattern.empty()) {
+        return 0;
+    }
+    return countOccurrences(text, searcher(pattern));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue StringUtil::replaceAll(const DmxStringValue &text, const SubstringSearcher &needle, const DmxStringValue &replacement) {
+//
+//Purpose
+//-------
+// replace every non-overlapping occurrence; text is unchanged for an empty needle
+//
+    size_t length = needle.needle().size();
+    if (length == 0) {
+        return text;
+    }
+
+    size_t position = needle.find(text.data(), text.size(), 0);
+    if (position == std::string::npos) {
+        return text;
+    }
+
+    DmxStringValue result;
+    result.reserve(text.size());
+    size_t copied = 0;
+    for (; position != std::string::npos; position = needle.find(text.data(), text.size(), copied)) {
+        result.append(text, copied, position - copied);
+        result.append(replacement);
+        copied = position + length;
+    }
+    result.append(text, copied, std::string::npos);
+    return result;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue StringUtil::replaceAll(const DmxStringValue &text, const DmxStringValue &pattern, const DmxStringValue &replacement) {
+//
+//Purpose
+//-------
+// replaceAll with a cached searcher
+//
+    if (pattern.empty()) {
+        return text;
+    }
+    return replaceAll(text, searcher(pattern), replacement);
+}
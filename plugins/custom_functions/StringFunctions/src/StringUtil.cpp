@@ -1,175 +1,214 @@
-/*******************************************************************************
-
- Copyright (c) 2017-present
-
- *******************************************************************************/
-#include <string>
-#include "StringUtil.h"
-#include <algorithm>
-#include <map>
-#include <vector>
-#include <sstream>
-#include <numeric>
-
-/******************************************************************************/
-
-struct trieNode {
-    bool isWord;
-    char key;
-    std::string text;
-    size_t frequency;
-    std::map<char, trieNode*> children;
-};
-
-/****************************** MEMBER FUNCTION *******************************/
-std::string StringUtil::stringReverse(const std::string &text) {
-//
-//Purpose
-//-------
-//reverse a string
-//
-    std::string copyText(text);
-    std::reverse(copyText.begin(), copyText.end());
-    return copyText;
-}
-
-/****************************** MEMBER FUNCTION *******************************/
-trieNode* createNode(trieNode* parent, char key, bool isWord) {
-//
-//Purpose
-//-------
-// create a new Trie Node
-//
-    trieNode *child = new trieNode;
-    child->isWord = false;
-    child->key = '\0';
-    child->frequency = 0;
-
-    if (parent != NULL) {
-        parent->isWord = isWord;
-        parent->key = key;
-        parent->children[key] = child;
-        parent->frequency = 0;
-    } else {
-        parent = child;
-    }
-
-    return parent;
-}
-
-/****************************** MEMBER FUNCTION *******************************/
-trieNode * checkIfKeyExist(trieNode* curr, char c) {
-//
-//Purpose
-//-------
-// checks if a key exist in the map
-//
-    if (curr->children.find(c) == curr->children.end()) {
-        return NULL;
-    } else {
-        return curr;
-    }
-}
-
-/****************************** MEMBER FUNCTION *******************************/
-void insertTrie(trieNode*& curr, std::string word) {
-//
-//Purpose
-//-------
-// insert a stirng into Trie
-//
-    trieNode * currentNode = curr;
-
-    for (size_t i = 0; i < word.length(); i++) {
-        char key = word[i];
-        if (checkIfKeyExist(currentNode, key) == NULL) {
-            currentNode = createNode(currentNode, key, false);
-        }
-        currentNode = currentNode->children[key];
-    }
-    //for last node
-    currentNode->isWord = true;
-    currentNode->frequency = currentNode->frequency + 1;
-    currentNode->text = word;
-}
-
-/****************************** MEMBER FUNCTION *******************************/
-void traverseTrie(trieNode* root, unsigned& maxCount, std::map<std::string, unsigned>& mFrequent) {
-//
-//Purpose
-//-------
-// Preorder traversal of Trie
-//
-    trieNode* currentNode = root;
-
-    std::map<char, trieNode*>::iterator it;
-
-    for (it = currentNode->children.begin(); it != currentNode->children.end(); it++) {
-        //if greater frequency word is found
-        if (maxCount < it->second->frequency) {
-            mFrequent.clear();
-            maxCount = it->second->frequency;
-            mFrequent[it->second->text] = it->second->frequency;
-        }
-        //collect all words if same frequency
-        if (maxCount == it->second->frequency) {
-            //check if duplicates is not there
-            if ( mFrequent.find(it->second->text) == mFrequent.end() ) {
-                mFrequent[it->second->text] = it->second->frequency;
-            }
-        }
-        traverseTrie(it->second, maxCount, mFrequent);
-    }
-}
-
-/****************************** MEMBER FUNCTION *******************************/
-std::string StringUtil::frequentWord(const std::string &text) {
-//
-//Purpose
-//-------
-// return the most frequent words with its frequency
-//
-    std::vector<std::string> sText;
-    std::stringstream streamText(text);
-    std::string currText;
-    std::string resultText = "";
-
-    /* extract all the words in a string */
-    for (size_t i = 0;  streamText >> currText; i++) {
-        sText.push_back(currText);
-    }
-
-    //create an empty node
-    trieNode * root = createNode(NULL, '\0', false);
-
-    /* for every words in a string, add to a Trie */
-    for (std::vector<std::string>::const_iterator iterString = sText.begin(); iterString != sText.end(); iterString++) {
-        insertTrie(root, *iterString);
-    }
-
-    /* get most frequent word */
-    std::map<std::string, unsigned> mFrequent;
-    unsigned maxCount = 0;
-
-    /* do a preorder traversal */
-    traverseTrie(root, maxCount, mFrequent);
-
-    std::map<std::string, unsigned>::iterator it;
-    std::stringstream ss;
-
-    /* getting result & formatting*/
-    resultText += "[";
-    for (it = mFrequent.begin(); it != mFrequent.end(); it++) {
-        ss.str(std::string());
-        ss << it->second;
-        resultText += "{" + it->first + ":" +  ss.str() + "}";
-    }
-    resultText += "]";
-
-    //cleaning
-    //TODO
-    //dellocate pointers
-    sText.clear();
-    mFrequent.clear();
-    return resultText;
-}
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ *******************************************************************************/
+#include <string>
+#include "dmx_custom_functions.h"
+#include "StringUtil.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <numeric>
+#include <cctype>
+
+/******************************************************************************/
+
+struct trieNode;
+
+typedef std::map<char, trieNode*, std::less<char>,
+                 DmxArenaAllocator<std::pair<const char, trieNode*> > > trieChildren;
+
+typedef std::vector<const trieNode*, DmxAllocator<const trieNode*> > trieNodeList;
+
+/* Trie nodes and their child maps live in the arena of one frequentWord call */
+struct trieNode {
+    explicit trieNode(DmxArena& arena)
+    : isWord(false),
+      key('\0'),
+      textPtr(NULL),
+      textLength(0),
+      frequency(0),
+      children(std::less<char>(), trieChildren::allocator_type(arena))
+    {
+    }
+
+    bool isWord;
+    char key;
+    const char* textPtr;        // the word inside the input text
+    size_t textLength;
+    size_t frequency;
+    trieChildren children;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue StringUtil::stringReverse(const DmxStringValue &text) {
+//
+//Purpose
+//-------
+//reverse a string
+//
+    DmxStringValue copyText(text);
+    std::reverse(copyText.begin(), copyText.end());
+    return copyText;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+trieNode* createNode(DmxArena& arena, trieNode* parent, char key) {
+//
+//Purpose
+//-------
+// create a new Trie Node, returns the parent (or the new node without parent)
+//
+    trieNode *child = arena.create<trieNode>(arena);
+    child->key = key;
+
+    if (parent != NULL) {
+        parent->children[key] = child;
+    } else {
+        parent = child;
+    }
+
+    return parent;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+trieNode * checkIfKeyExist(trieNode* curr, char c) {
+//
+//Purpose
+//-------
+// checks if a key exist in the map
+//
+    if (curr->children.find(c) == curr->children.end()) {
+        return NULL;
+    } else {
+        return curr;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void insertTrie(DmxArena& arena, trieNode*& curr, const char* word, size_t length) {
+//
+//Purpose
+//-------
+// insert a stirng into Trie
+//
+    trieNode * currentNode = curr;
+
+    for (size_t i = 0; i < length; i++) {
+        char key = word[i];
+        if (checkIfKeyExist(currentNode, key) == NULL) {
+            currentNode = createNode(arena, currentNode, key);
+        }
+        currentNode = currentNode->children[key];
+    }
+    //for last node
+    currentNode->isWord = true;
+    currentNode->frequency = currentNode->frequency + 1;
+    currentNode->textPtr = word;
+    currentNode->textLength = length;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+void traverseTrie(trieNode* root, size_t& maxCount, trieNodeList& mFrequent, DmxStopPoller& poller) {
+//
+//Purpose
+//-------
+// Preorder traversal of Trie with an explicit stack, words can be arbitrarily long;
+// one poll tick per node
+//
+    trieNodeList pending;
+    pending.push_back(root);
+
+    while (!pending.empty()) {
+        const trieNode* currentNode = pending.back();
+        pending.pop_back();
+        poller.tick();
+
+        for (trieChildren::const_iterator it = currentNode->children.begin(); it != currentNode->children.end(); it++) {
+            const trieNode* child = it->second;
+            if (child->isWord) {
+                //if greater frequency word is found
+                if (maxCount < child->frequency) {
+                    mFrequent.clear();
+                    maxCount = child->frequency;
+                }
+                //collect all words if same frequency
+                if (maxCount == child->frequency) {
+                    mFrequent.push_back(child);
+                }
+            }
+            pending.push_back(child);
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool compareNodeText(const trieNode* first, const trieNode* second) {
+//
+//Purpose
+//-------
+// byte order of the words, shorter first on a common prefix
+//
+    int comparison = memcmp(first->textPtr, second->textPtr, std::min(first->textLength, second->textLength));
+    return (comparison != 0) ? comparison < 0 : first->textLength < second->textLength;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+DmxStringValue StringUtil::frequentWord(const DmxStringValue &text) {
+//
+//Purpose
+//-------
+// return the most frequent words with its frequency
+//
+    DmxArena arena;
+    DmxStopPoller poller;
+    DmxStringValue resultText;
+
+    //create an empty node
+    trieNode * root = createNode(arena, NULL, '\0');
+
+    /* for every whitespace separated word in the string, add to a Trie;
+       one poll tick per byte scanned */
+    const char* textPtr = text.data();
+    size_t length = text.size();
+    for (size_t i = 0; i < length; ) {
+        size_t scanStart = i;
+        while (i < length && isspace(static_cast<unsigned char>(textPtr[i]))) {
+            i++;
+        }
+        size_t wordStart = i;
+        while (i < length && !isspace(static_cast<unsigned char>(textPtr[i]))) {
+            i++;
+        }
+        if (i > wordStart) {
+            insertTrie(arena, root, textPtr + wordStart, i - wordStart);
+        }
+        poller.tick(static_cast<long long>(i - scanStart));
+    }
+
+    /* get most frequent word */
+    trieNodeList mFrequent;
+    size_t maxCount = 0;
+
+    /* do a preorder traversal */
+    traverseTrie(root, maxCount, mFrequent, poller);
+    std::sort(mFrequent.begin(), mFrequent.end(), compareNodeText);
+
+    /* getting result & formatting*/
+    resultText += "[";
+    for (trieNodeList::const_iterator it = mFrequent.begin(); it != mFrequent.end(); it++) {
+        char frequency[24];
+        int frequencyLength = snprintf(frequency, sizeof(frequency), "%lu", static_cast<unsigned long>((*it)->frequency));
+        resultText += "{";
+        resultText.append((*it)->textPtr, (*it)->textLength);
+        resultText += ":";
+        resultText.append(frequency, frequencyLength);
+        resultText += "}";
+    }
+    resultText += "]";
+
+    //the arena releases the trie
+    return resultText;
+}
@@ -14,12 +14,20 @@ To define the C++ interface for custom functions.
 #include <stdexcept>
 #include <time.h>
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 /******************************************************************************/
 /* Custom function return statuses */
 
 #define DMX_CUSTOM_FUNCTION_SUCCESS     0
 #define DMX_CUSTOM_FUNCTION_FAILURE     (-1)
 #define DMX_CUSTOM_FUNCTION_EXCEPTION   (-2)
+#define DMX_CUSTOM_FUNCTION_TIMEOUT     (-3)
 
 /******************************************************************************/
 /* Custom function API version */
@@ -32,6 +40,29 @@ To define the C++ interface for custom functions.
 #define DMX_GET_CUSTOM_FUNCTION_NAMES               dmxGetCustomFunctionNames
 #define DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX    dmxGetArgTypes
 
+/* Optional library initialization, called by the host before any custom function */
+
+#define DMX_INIT_CUSTOM_FUNCTION_LIBRARY            dmxInitCustomFunctionLibrary
+
+/* Optional cooperative cancellation, see DmxCancelToken */
+
+#define DMX_SET_CUSTOM_FUNCTION_CANCEL_TOKEN        dmxSetCancelToken
+#define DMX_GET_CUSTOM_FUNCTION_TIMED_OUT_CALLS     dmxGetTimedOutCalls
+
+/* Optional streaming variant of a function, entry point prefixes */
+
+#define DMX_GET_CUSTOM_FUNCTION_STREAM_INFO_PREFIX  dmxGetStreamInfo
+#define DMX_BEGIN_CUSTOM_FUNCTION_STREAM_PREFIX     dmxBeginStream
+#define DMX_CUSTOM_FUNCTION_STREAM_CHUNK_PREFIX     dmxStreamChunk
+#define DMX_END_CUSTOM_FUNCTION_STREAM_PREFIX       dmxEndStream
+
+/* Optional prepare phase of a function, entry point prefixes */
+
+#define DMX_GET_CUSTOM_FUNCTION_PREPARE_INFO_PREFIX dmxGetPrepareInfo
+#define DMX_PREPARE_CUSTOM_FUNCTION_PREFIX          dmxPrepare
+#define DMX_CALL_PREPARED_CUSTOM_FUNCTION_PREFIX    dmxCallPrepared
+#define DMX_RELEASE_CUSTOM_FUNCTION_PREFIX          dmxRelease
+
 /******************************************************************************/
 /* Custom function argument type ids */
 
@@ -62,6 +93,110 @@ struct DmxDateTimeBuffer
     double m_fractionalSecond;
 };
 
+/* Host memory callbacks, passed to DMX_INIT_CUSTOM_FUNCTION_LIBRARY. Plugin heap
+   memory taken through the SDK (DmxString values, DmxStringValue, DmxAllocator,
+   DmxArena, dmxCreate, the prepared states and the stream states) comes from
+   these callbacks and is accounted per call; a call holding more than
+   m_callBudget bytes fails with DMX_CUSTOM_FUNCTION_FAILURE. Memory a plugin
+   takes with new, malloc or the standard allocator bypasses them. */
+
+typedef void* (*DmxAllocateCallback)(void* contextPtr, size_t size);
+typedef void* (*DmxReallocateCallback)(void* contextPtr, void* dataPtr, size_t size);
+typedef void (*DmxFreeCallback)(void* contextPtr, void* dataPtr);
+typedef void (*DmxReportPeakMemoryCallback)(void* contextPtr, const char* functionNamePtr, size_t peakSize);
+
+struct DmxMemoryCallbacks
+{
+    DmxAllocateCallback m_allocatePtr;          // NULL for the C runtime heap
+    DmxFreeCallback m_freePtr;
+    DmxReallocateCallback m_reallocatePtr;
+    void* m_contextPtr;
+    size_t m_callBudget;                        // bytes a call may hold at once, 0 for no limit
+    DmxReportPeakMemoryCallback m_reportPeakPtr; // peak bytes of each call, may be NULL
+};
+
+/* Cancellation: a host bounding call latency installs a token for the calls
+   made on a thread with
+       void dmxSetCancelToken(const DmxCancelToken* tokenPtr)
+   and NULL to remove it; the token must stay valid while installed. Each call
+   then runs for at most m_callTimeout nanoseconds, and stops soon after
+   another thread sets *m_cancelFlagPtr, a plain int the host writes with an
+   atomic store such as __atomic_store_n. Long loops poll the token every few
+   thousand iterations; a stopped call returns DMX_CUSTOM_FUNCTION_TIMEOUT and
+   is counted by
+       unsigned long long dmxGetTimedOutCalls() */
+
+struct DmxCancelToken
+{
+    const int* m_cancelFlagPtr;                 // nonzero to stop the running call, may be NULL
+    unsigned long long m_callTimeout;           // nanoseconds a call may run, 0 for no limit
+};
+
+/* Streaming: a function with one string argument may also export
+       const DmxStreamInfo* dmxGetStreamInfo<name>()
+       void* dmxBeginStream<name>(DmxByteBuffer* exceptionBufferPtr, const DmxStreamOutput* outputPtr)
+       int dmxStreamChunk<name>(DmxByteBuffer* exceptionBufferPtr, void* streamPtr, const char* dataPtr, size_t size)
+       int dmxEndStream<name>(DmxByteBuffer* exceptionBufferPtr, void* streamPtr, bool isAborted)
+   The host feeds the input in chunks of any size, in m_direction order, and
+   receives the output through m_writePtr in chunks of at most
+   m_outputChunkSize bytes. End must be called once per stream, with isAborted
+   set after a failed chunk; it releases the stream in every case. */
+
+#define DMX_STREAM_FORWARD          0           // chunks from the start of the value
+#define DMX_STREAM_REVERSE          1           // chunks from the end of the value, bytes in order
+
+typedef int (*DmxStreamWriteCallback)(void* contextPtr, const char* dataPtr, size_t size);
+
+struct DmxStreamOutput
+{
+    DmxStreamWriteCallback m_writePtr;          // returns 0 on success
+    void* m_contextPtr;
+};
+
+struct DmxStreamInfo
+{
+    int m_direction;
+    size_t m_outputChunkSize;
+};
+
+/* Prepare: a function whose setup depends only on some of its arguments may
+   also export
+       const DmxPrepareInfo* dmxGetPrepareInfo<name>()
+       void* dmxPrepare<name>(DmxByteBuffer* exceptionBufferPtr, void* const* argumentPtrs)
+       int dmxCallPrepared<name>(DmxByteBuffer* exceptionBufferPtr, void* statePtr,
+                                 bool* isOutputNullPtr, void* const* argumentPtrs)
+       void dmxRelease<name>(void* statePtr)
+   argumentPtrs holds the argument buffers in declaration order, output first.
+   When the arguments in m_constantArguments are constant for a job, the host
+   may prepare once with those arguments (the others may be NULL), then call
+   the prepared entry point for every row with all arguments, and release the
+   state at the end. Prepare returns NULL after an exception. A state is
+   read-only once prepared and may be shared by concurrent calls. */
+
+#define DMX_CONSTANT_ARGUMENT(index)    (1u << (index))
+
+struct DmxPrepareInfo
+{
+    unsigned m_constantArguments;               // DMX_CONSTANT_ARGUMENT bits, the output is argument 0
+};
+
+/* Argument capture: with DMX_CAPTURE_DIR set in the environment, every function
+   keeps a reservoir sample of DMX_CAPTURE_SAMPLES calls (default 1000) and
+   writes it to <DMX_CAPTURE_DIR>/<name>.dmxcap when the library is unloaded.
+   The file is in host byte order:
+       magic, u32 name length, name, u32 argument count, one byte type id per
+       argument (output first), u64 calls seen, u32 record count, then per
+       record a u32 length and the input arguments
+   Each argument is a byte set to 1 if it is null, followed otherwise by
+       string: u64 length and the bytes
+       int, unsigned int, double: the 8 byte value
+       date time: i32 year, month, day, hour, minute, second (struct tm
+                  fields) and the double fractional second */
+
+#define DMX_CAPTURE_FILE_MAGIC      "DMXCAP1\n"
+#define DMX_CAPTURE_FILE_EXTENSION  ".dmxcap"
+#define DMX_CAPTURE_DEFAULT_SAMPLES 1000
+
 /******************************************************************************/
 /* Custom function argument base type */
 
@@ -69,6 +204,7 @@ template<typename T, DmxTypeId typeId>
 class DmxTypeBase
 {
 public:
+    typedef T BufferType;
     static const DmxTypeId s_typeId = typeId;
 public:
     virtual ~DmxTypeBase() {}
@@ -119,32 +255,7 @@ typedef DmxNumericType<double,              DMXTYPEID_DOUBLE>           DmxDoubl
 
 typedef DmxTypeBase<DmxByteBuffer,          DMXTYPEID_STRING>           DmxStringBase;
 
-class DmxString : public DmxStringBase, public std::string
-{
-public:
-    using std::string::operator=;
-    DmxString(void* bufferPtr, bool isOutput = false)
-    : DmxStringBase(bufferPtr, isOutput)
-    {
-        if (!m_isOutput && m_bufferPtr != NULL) {
-            this->assign(m_bufferPtr->m_dataPtr, m_bufferPtr->m_size);
-        }
-    }
-    ~DmxString()
-    {
-        if (m_isOutput && m_bufferPtr != NULL) {
-            size_t length = (this->length() < m_bufferPtr->m_bufferSize) ? this->length() : m_bufferPtr->m_bufferSize;
-            for (size_t i = 0; i < length; ++i) {
-                (m_bufferPtr->m_dataPtr)[i] = this->at(i);
-            }
-            m_bufferPtr->m_size = length;
-        }
-    }
-    DmxString& operator=(const DmxString& rhs) {
-        std::string::operator=(rhs);
-        return *this;
-    }
-};
+/* DmxString keeps its value on the host memory callbacks, it is declared with them */
 
 /* Custom function argument datetime type */
 
@@ -228,6 +339,8 @@ public:
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) || defined(__WIN32__)
     #define DMX_DLL_EXPORT __declspec(dllexport)
+#elif defined(__GNUC__)
+    #define DMX_DLL_EXPORT __attribute__((visibility("default")))
 #else
     #define DMX_DLL_EXPORT
 #endif
@@ -235,32 +348,61 @@ public:
 #define DMX_EXPORT_FUNCTION \
     extern "C" DMX_DLL_EXPORT
 
+/* Library-wide definitions are emitted by every translation unit that includes
+   this header; the linker keeps a single copy, so a plugin may span many files */
+#if defined(__GNUC__)
+    #define DMX_LIBRARY_FUNCTION inline __attribute__((used))
+#else
+    #define DMX_LIBRARY_FUNCTION inline
+#endif
+
 /******************************************************************************/
 /* Custom function library metadata */
 
-DMX_EXPORT_FUNCTION const char* DMX_GET_CUSTOM_FUNCTION_API_VERSION() {
+DMX_EXPORT_FUNCTION DMX_LIBRARY_FUNCTION const char* DMX_GET_CUSTOM_FUNCTION_API_VERSION() {
     return DMX_CUSTOM_FUNCTION_API_VERSION;
 }
 
+#if defined(__GNUC__) && defined(__ELF__)
+
+/* Each function name pointer is placed in a dedicated section and the linker
+   provides its bounds: the name table is a constant array assembled at link
+   time, and no constructor runs when the library is loaded. */
+
+extern "C" const char* const __start_dmx_custom_function_names[] __attribute__((weak, visibility("hidden")));
+extern "C" const char* const __stop_dmx_custom_function_names[] __attribute__((weak, visibility("hidden")));
+
+DMX_EXPORT_FUNCTION DMX_LIBRARY_FUNCTION const char* const* DMX_GET_CUSTOM_FUNCTION_NAMES(size_t* numFunctionsPtr) {
+    *numFunctionsPtr = __stop_dmx_custom_function_names - __start_dmx_custom_function_names;
+    return __start_dmx_custom_function_names;
+}
+
+#define DECLARE_DMX_CUSTOM_FUNCTION_NAME(functionName) \
+    static const char* const DMX_CONCAT(dmxCustomFunctionName, functionName) \
+        __attribute__((section("dmx_custom_function_names"), used, aligned(sizeof(const char*)))) = DMX_STRINGIFY(functionName);
+
+#else
+
+/* Other toolchains register the names from static constructors */
+
 class DmxCustomFunctionNames
 {
 public:
-    DmxCustomFunctionNames(const char* functionNamePtr) { s_functionNames.push_back(functionNamePtr); }
-    static const std::vector<const char*>& get() { return s_functionNames; }
-private:
-    static std::vector<const char*> s_functionNames;
+    DmxCustomFunctionNames(const char* functionNamePtr) { get().push_back(functionNamePtr); }
+    static std::vector<const char*>& get() { static std::vector<const char*> s_functionNames; return s_functionNames; }
 };
-std::vector<const char*> DmxCustomFunctionNames::s_functionNames;
 
-DMX_EXPORT_FUNCTION const char* const* DMX_GET_CUSTOM_FUNCTION_NAMES(size_t* numFunctionsPtr) {
+DMX_EXPORT_FUNCTION DMX_LIBRARY_FUNCTION const char* const* DMX_GET_CUSTOM_FUNCTION_NAMES(size_t* numFunctionsPtr) {
     const std::vector<const char*>& functionNames = DmxCustomFunctionNames::get();
     *numFunctionsPtr = functionNames.size();
-    return &functionNames[0];
+    return functionNames.empty() ? NULL : &functionNames[0];
 }
 
 #define DECLARE_DMX_CUSTOM_FUNCTION_NAME(functionName) \
     static const DmxCustomFunctionNames DMX_CONCAT(dmxCustomFunctionName, functionName)(DMX_STRINGIFY(functionName));
 
+#endif
+
 /******************************************************************************/
 /* Custom function metadata */
 
@@ -289,10 +431,636 @@ DMX_EXPORT_FUNCTION const char* const* DMX_GET_CUSTOM_FUNCTION_NAMES(size_t* num
 #define DMX_DATE_TIME(variableName) \
     DmxDateTime, variableName
 
+/******************************************************************************/
+/* Custom function cancellation */
+
+/* Cancel token of the calls made on this thread */
+struct DmxCallDeadline
+{
+    const DmxCancelToken* m_tokenPtr;           // NULL when the host installed none
+    long long m_deadline;                       // steady clock nanoseconds, 0 for no limit
+};
+
+DMX_LIBRARY_FUNCTION DmxCallDeadline& dmxCallDeadline() {
+    static thread_local DmxCallDeadline s_callDeadline = { NULL, 0 };
+    return s_callDeadline;
+}
+
+DMX_LIBRARY_FUNCTION std::atomic<unsigned long long>& dmxTimedOutCalls() {
+    static std::atomic<unsigned long long> s_timedOutCalls(0);
+    return s_timedOutCalls;
+}
+
+DMX_EXPORT_FUNCTION DMX_LIBRARY_FUNCTION void DMX_SET_CUSTOM_FUNCTION_CANCEL_TOKEN(const DmxCancelToken* tokenPtr) {
+    dmxCallDeadline().m_tokenPtr = tokenPtr;
+}
+
+DMX_EXPORT_FUNCTION DMX_LIBRARY_FUNCTION unsigned long long DMX_GET_CUSTOM_FUNCTION_TIMED_OUT_CALLS() {
+    return dmxTimedOutCalls().load(std::memory_order_relaxed);
+}
+
+DMX_LIBRARY_FUNCTION long long dmxSteadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Start the clock of the call running on this thread */
+DMX_LIBRARY_FUNCTION void dmxStartCallClock() {
+    DmxCallDeadline& callDeadline = dmxCallDeadline();
+    const DmxCancelToken* tokenPtr = callDeadline.m_tokenPtr;
+    callDeadline.m_deadline = (tokenPtr != NULL && tokenPtr->m_callTimeout != 0)
+                            ? dmxSteadyNanoseconds() + static_cast<long long>(tokenPtr->m_callTimeout) : 0;
+}
+
+/* Relaxed read of the cancel flag, which another thread writes */
+DMX_LIBRARY_FUNCTION int dmxLoadCancelFlag(const int* flagPtr) {
+#if defined(__GNUC__)
+    return __atomic_load_n(flagPtr, __ATOMIC_RELAXED);
+#else
+    return *static_cast<const volatile int*>(flagPtr);
+#endif
+}
+
+/* True once the running call should give up: cancelled or past its deadline */
+DMX_LIBRARY_FUNCTION bool dmxShouldStop() {
+    const DmxCallDeadline& callDeadline = dmxCallDeadline();
+    const DmxCancelToken* tokenPtr = callDeadline.m_tokenPtr;
+    if (tokenPtr == NULL) {
+        return false;
+    }
+    if (tokenPtr->m_cancelFlagPtr != NULL && dmxLoadCancelFlag(tokenPtr->m_cancelFlagPtr) != 0) {
+        return true;
+    }
+    return callDeadline.m_deadline != 0 && dmxSteadyNanoseconds() >= callDeadline.m_deadline;
+}
+
+/* Thrown when a call stops early, the call returns DMX_CUSTOM_FUNCTION_TIMEOUT */
+class DmxCallTimedOut : public std::exception
+{
+public:
+    const char* what() const throw() { return "call cancelled or past its deadline"; }
+};
+
+/* Countdown between two token checks, so that a long loop pays a decrement
+   per iteration */
+#define DMX_STOP_POLL_INTERVAL      4096
+
+class DmxStopPoller
+{
+public:
+    explicit DmxStopPoller(long long interval = DMX_STOP_POLL_INTERVAL)
+    : m_interval(interval),
+      m_countdown(interval)
+    {
+    }
+    // count work units done; throws DmxCallTimedOut once the call should stop
+    void tick(long long work = 1) {
+        m_countdown -= work;
+        if (m_countdown <= 0) {
+            m_countdown = m_interval;
+            if (dmxShouldStop()) {
+                throw DmxCallTimedOut();
+            }
+        }
+    }
+private:
+    long long m_interval;
+    long long m_countdown;
+};
+
+/******************************************************************************/
+/* Custom function memory */
+
+/* Host callbacks installed at initialization */
+DMX_LIBRARY_FUNCTION DmxMemoryCallbacks& dmxMemoryCallbacks() {
+    static DmxMemoryCallbacks s_memoryCallbacks = { NULL, NULL, NULL, NULL, 0, NULL };
+    return s_memoryCallbacks;
+}
+
+DMX_EXPORT_FUNCTION DMX_LIBRARY_FUNCTION int DMX_INIT_CUSTOM_FUNCTION_LIBRARY(const DmxMemoryCallbacks* memoryCallbacksPtr) {
+    static const DmxMemoryCallbacks s_defaultCallbacks = { NULL, NULL, NULL, NULL, 0, NULL };
+    if (memoryCallbacksPtr != NULL && memoryCallbacksPtr->m_allocatePtr != NULL
+        && (memoryCallbacksPtr->m_freePtr == NULL || memoryCallbacksPtr->m_reallocatePtr == NULL)) {
+        return DMX_CUSTOM_FUNCTION_FAILURE;
+    }
+    dmxMemoryCallbacks() = (memoryCallbacksPtr != NULL) ? *memoryCallbacksPtr : s_defaultCallbacks;
+    return DMX_CUSTOM_FUNCTION_SUCCESS;
+}
+
+/* Memory accounting of the call running on this thread */
+struct DmxCallMemory
+{
+    const char* m_functionNamePtr;              // NULL outside a custom function call
+    size_t m_size;
+    size_t m_peakSize;
+};
+
+DMX_LIBRARY_FUNCTION DmxCallMemory& dmxCallMemory() {
+    static thread_local DmxCallMemory s_callMemory = { NULL, 0, 0 };
+    return s_callMemory;
+}
+
+/* Thrown when a call would exceed its memory budget */
+class DmxMemoryBudgetExceeded : public std::bad_alloc
+{
+public:
+    DmxMemoryBudgetExceeded(const char* functionNamePtr, size_t requestedSize, size_t budget)
+    {
+        snprintf(m_message, sizeof(m_message), "%s: memory budget of %lu bytes exceeded (requested %lu bytes)",
+                 functionNamePtr, static_cast<unsigned long>(budget), static_cast<unsigned long>(requestedSize));
+    }
+    const char* what() const throw() { return m_message; }
+private:
+    char m_message[256];
+};
+
+/* Opens the accounting of one custom function call and reports its peak;
+   also starts the call clock of the cancel token */
+class DmxCallScope
+{
+public:
+    explicit DmxCallScope(const char* functionNamePtr)
+    : m_callMemory(dmxCallMemory())
+    {
+        m_callMemory.m_functionNamePtr = functionNamePtr;
+        m_callMemory.m_size = 0;
+        m_callMemory.m_peakSize = 0;
+        dmxStartCallClock();
+    }
+    ~DmxCallScope()
+    {
+        const DmxMemoryCallbacks& callbacks = dmxMemoryCallbacks();
+        if (callbacks.m_reportPeakPtr != NULL && m_callMemory.m_peakSize != 0) {
+            callbacks.m_reportPeakPtr(callbacks.m_contextPtr, m_callMemory.m_functionNamePtr, m_callMemory.m_peakSize);
+        }
+        m_callMemory.m_functionNamePtr = NULL;
+    }
+private:
+    DmxCallScope(const DmxCallScope&);
+    DmxCallScope& operator=(const DmxCallScope&);
+
+    DmxCallMemory& m_callMemory;
+};
+
+/* Blocks carry their size in front of the data for accounting */
+#define DMX_MEMORY_HEADER_SIZE      16
+
+DMX_LIBRARY_FUNCTION void dmxChargeMemory(size_t size) {
+    DmxCallMemory& callMemory = dmxCallMemory();
+    size_t budget = dmxMemoryCallbacks().m_callBudget;
+    if (callMemory.m_functionNamePtr != NULL && budget != 0
+        && (callMemory.m_size > budget || size > budget - callMemory.m_size)) {
+        throw DmxMemoryBudgetExceeded(callMemory.m_functionNamePtr, size, budget);
+    }
+    callMemory.m_size += size;
+    if (callMemory.m_size > callMemory.m_peakSize) {
+        callMemory.m_peakSize = callMemory.m_size;
+    }
+}
+
+DMX_LIBRARY_FUNCTION void dmxCreditMemory(size_t size) {
+    /* blocks may outlive the call that allocated them */
+    DmxCallMemory& callMemory = dmxCallMemory();
+    callMemory.m_size = (size < callMemory.m_size) ? callMemory.m_size - size : 0;
+}
+
+DMX_LIBRARY_FUNCTION void* dmxAllocateMemory(size_t size) {
+    if (size > static_cast<size_t>(-1) - DMX_MEMORY_HEADER_SIZE) {
+        throw std::bad_alloc();
+    }
+    dmxChargeMemory(size);
+    const DmxMemoryCallbacks& callbacks = dmxMemoryCallbacks();
+    void* blockPtr = (callbacks.m_allocatePtr != NULL)
+        ? callbacks.m_allocatePtr(callbacks.m_contextPtr, size + DMX_MEMORY_HEADER_SIZE)
+        : malloc(size + DMX_MEMORY_HEADER_SIZE);
+    if (blockPtr == NULL) {
+        dmxCreditMemory(size);
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(blockPtr) = size;
+    return static_cast<char*>(blockPtr) + DMX_MEMORY_HEADER_SIZE;
+}
+
+DMX_LIBRARY_FUNCTION void dmxFreeMemory(void* dataPtr) {
+    if (dataPtr == NULL) {
+        return;
+    }
+    void* blockPtr = static_cast<char*>(dataPtr) - DMX_MEMORY_HEADER_SIZE;
+    dmxCreditMemory(*static_cast<size_t*>(blockPtr));
+    const DmxMemoryCallbacks& callbacks = dmxMemoryCallbacks();
+    if (callbacks.m_freePtr != NULL) {
+        callbacks.m_freePtr(callbacks.m_contextPtr, blockPtr);
+    } else {
+        free(blockPtr);
+    }
+}
+
+DMX_LIBRARY_FUNCTION void* dmxReallocateMemory(void* dataPtr, size_t size) {
+    if (dataPtr == NULL) {
+        return dmxAllocateMemory(size);
+    }
+    if (size > static_cast<size_t>(-1) - DMX_MEMORY_HEADER_SIZE) {
+        throw std::bad_alloc();
+    }
+    void* blockPtr = static_cast<char*>(dataPtr) - DMX_MEMORY_HEADER_SIZE;
+    size_t oldSize = *static_cast<size_t*>(blockPtr);
+    if (size > oldSize) {
+        dmxChargeMemory(size - oldSize);
+    }
+    const DmxMemoryCallbacks& callbacks = dmxMemoryCallbacks();
+    void* resizedPtr = (callbacks.m_reallocatePtr != NULL)
+        ? callbacks.m_reallocatePtr(callbacks.m_contextPtr, blockPtr, size + DMX_MEMORY_HEADER_SIZE)
+        : realloc(blockPtr, size + DMX_MEMORY_HEADER_SIZE);
+    if (resizedPtr == NULL) {
+        if (size > oldSize) {
+            dmxCreditMemory(size - oldSize);
+        }
+        throw std::bad_alloc();
+    }
+    if (size < oldSize) {
+        dmxCreditMemory(oldSize - size);
+    }
+    *static_cast<size_t*>(resizedPtr) = size;
+    return static_cast<char*>(resizedPtr) + DMX_MEMORY_HEADER_SIZE;
+}
+
+/* Standard allocator on the host memory callbacks */
+template<typename T>
+class DmxAllocator
+{
+public:
+    typedef T value_type;
+    template<typename U> struct rebind { typedef DmxAllocator<U> other; };
+
+    DmxAllocator() {}
+    template<typename U> DmxAllocator(const DmxAllocator<U>&) {}
+
+    T* allocate(size_t count)
+    {
+        if (count > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(dmxAllocateMemory(count * sizeof(T)));
+    }
+    void deallocate(T* dataPtr, size_t) { dmxFreeMemory(dataPtr); }
+};
+
+template<typename T, typename U>
+inline bool operator==(const DmxAllocator<T>&, const DmxAllocator<U>&) { return true; }
+template<typename T, typename U>
+inline bool operator!=(const DmxAllocator<T>&, const DmxAllocator<U>&) { return false; }
+
+/* Bump allocator on the host memory callbacks; everything is released at once
+   when the arena is destroyed, object destructors are not run */
+class DmxArena
+{
+public:
+    explicit DmxArena(size_t chunkSize = 64 * 1024)
+    : m_chunkPtr(NULL),
+      m_nextPtr(NULL),
+      m_endPtr(NULL),
+      m_chunkSize(chunkSize)
+    {
+    }
+    ~DmxArena()
+    {
+        while (m_chunkPtr != NULL) {
+            void* previousPtr = *static_cast<void**>(m_chunkPtr);
+            dmxFreeMemory(m_chunkPtr);
+            m_chunkPtr = previousPtr;
+        }
+    }
+    void* allocate(size_t size, size_t alignment = DMX_MEMORY_HEADER_SIZE)
+    {
+        size_t padding = (alignment - reinterpret_cast<size_t>(m_nextPtr) % alignment) % alignment;
+        if (m_nextPtr == NULL || size + padding > static_cast<size_t>(m_endPtr - m_nextPtr)) {
+            size_t chunkSize = (size + alignment + DMX_MEMORY_HEADER_SIZE > m_chunkSize)
+                ? size + alignment + DMX_MEMORY_HEADER_SIZE : m_chunkSize;
+            void* chunkPtr = dmxAllocateMemory(chunkSize);
+            *static_cast<void**>(chunkPtr) = m_chunkPtr;
+            m_chunkPtr = chunkPtr;
+            m_nextPtr = static_cast<char*>(chunkPtr) + DMX_MEMORY_HEADER_SIZE;
+            m_endPtr = static_cast<char*>(chunkPtr) + chunkSize;
+            padding = (alignment - reinterpret_cast<size_t>(m_nextPtr) % alignment) % alignment;
+        }
+        void* dataPtr = m_nextPtr + padding;
+        m_nextPtr += padding + size;
+        return dataPtr;
+    }
+    template<typename T, typename... Args> T* create(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+private:
+    DmxArena(const DmxArena&);
+    DmxArena& operator=(const DmxArena&);
+
+    void* m_chunkPtr;                           // most recent chunk, chained to the previous one
+    char* m_nextPtr;
+    char* m_endPtr;
+    size_t m_chunkSize;
+};
+
+/* Standard allocator on an arena, for containers that live inside it */
+template<typename T>
+class DmxArenaAllocator
+{
+public:
+    typedef T value_type;
+    template<typename U> struct rebind { typedef DmxArenaAllocator<U> other; };
+
+    explicit DmxArenaAllocator(DmxArena& arena) : m_arenaPtr(&arena) {}
+    template<typename U> DmxArenaAllocator(const DmxArenaAllocator<U>& rhs) : m_arenaPtr(rhs.arena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(m_arenaPtr->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+    DmxArena* arena() const { return m_arenaPtr; }
+private:
+    DmxArena* m_arenaPtr;
+};
+
+template<typename T, typename U>
+inline bool operator==(const DmxArenaAllocator<T>& lhs, const DmxArenaAllocator<U>& rhs) { return lhs.arena() == rhs.arena(); }
+template<typename T, typename U>
+inline bool operator!=(const DmxArenaAllocator<T>& lhs, const DmxArenaAllocator<U>& rhs) { return lhs.arena() != rhs.arena(); }
+
+/* String on the host memory callbacks */
+typedef std::basic_string<char, std::char_traits<char>, DmxAllocator<char> > DmxStringValue;
+
+/* Object on the host memory callbacks, released with dmxDestroy */
+template<typename T, typename... Args>
+inline T* dmxCreate(Args&&... args) {
+    void* dataPtr = dmxAllocateMemory(sizeof(T));
+    try {
+        return new (dataPtr) T(std::forward<Args>(args)...);
+    } catch (...) {
+        dmxFreeMemory(dataPtr);
+        throw;
+    }
+}
+
+template<typename T>
+inline void dmxDestroy(T* objectPtr) {
+    if (objectPtr != NULL) {
+        objectPtr->~T();
+        dmxFreeMemory(objectPtr);
+    }
+}
+
+/******************************************************************************/
+/* Custom function argument string type */
+
+/* Input values are copied from the host buffer, output values are copied to it
+   when the call returns unless written directly */
+class DmxString : public DmxStringBase, public DmxStringValue
+{
+public:
+    using DmxStringValue::operator=;
+    DmxString(void* bufferPtr, bool isOutput = false)
+    : DmxStringBase(bufferPtr, isOutput),
+      m_isWrittenDirectly(false)
+    {
+        if (!m_isOutput && m_bufferPtr != NULL) {
+            this->assign(m_bufferPtr->m_dataPtr, m_bufferPtr->m_size);
+        }
+    }
+    ~DmxString()
+    {
+        if (m_isOutput && m_bufferPtr != NULL && !m_isWrittenDirectly) {
+            size_t length = (this->length() < m_bufferPtr->m_bufferSize) ? this->length() : m_bufferPtr->m_bufferSize;
+            if (length != 0) {
+                memcpy(m_bufferPtr->m_dataPtr, this->data(), length);
+            }
+            m_bufferPtr->m_size = length;
+        }
+    }
+    DmxString& operator=(const DmxString& rhs) {
+        DmxStringValue::operator=(rhs);
+        return *this;
+    }
+    DmxString& operator=(const std::string& rhs) {
+        assign(rhs.data(), rhs.size());
+        return *this;
+    }
+    /* Direct output: write at most getOutputCapacity() bytes to getOutputData(),
+       then call setOutputLength(); the string value is not copied afterwards */
+    char* getOutputData() const         { return m_bufferPtr->m_dataPtr; }
+    size_t getOutputCapacity() const    { return m_bufferPtr->m_bufferSize; }
+    void setOutputLength(size_t length)
+    {
+        m_bufferPtr->m_size = length;
+        m_isWrittenDirectly = true;
+    }
+    /* Host buffer of an input value, stable while the host passes the same
+       record to several calls; identity only, the copy in *this is the value */
+    const char* getInputData() const    { return m_bufferPtr->m_dataPtr; }
+private:
+    bool m_isWrittenDirectly;
+};
+
+/******************************************************************************/
+/* Custom function tracing */
+
+/* USDT probes of provider "dmx", for bpftrace, perf and SystemTap:
+       call__entry(const char* name, size_t inputSize, int numInputs)
+       call__return(const char* name, int status)
+       call__exception(const char* name, int status, const char* message)
+   inputSize is the total byte length of the string arguments; each chunk of a
+   stream and its finish fire a call of their own, the chunk with its size as
+   inputSize. A disabled probe is a single nop; probes are compiled out without
+   <sys/sdt.h> or with DMX_DISABLE_PROBES defined. */
+
+#if !defined(DMX_DISABLE_PROBES) && defined(__has_include)
+    #if __has_include(<sys/sdt.h>)
+        #include <sys/sdt.h>
+        #define DMX_PROBES_ENABLED 1
+    #endif
+#endif
+
+#if defined(DMX_PROBES_ENABLED)
+    #define DMX_PROBE_CALL_ENTRY(functionNamePtr, inputSize, numInputs) \
+        STAP_PROBE3(dmx, call__entry, functionNamePtr, inputSize, numInputs)
+    #define DMX_PROBE_CALL_RETURN(functionNamePtr, status) \
+        STAP_PROBE2(dmx, call__return, functionNamePtr, status)
+    #define DMX_PROBE_CALL_EXCEPTION(functionNamePtr, status, messagePtr) \
+        STAP_PROBE3(dmx, call__exception, functionNamePtr, status, messagePtr)
+#else
+    #define DMX_PROBE_CALL_ENTRY(functionNamePtr, inputSize, numInputs)
+    #define DMX_PROBE_CALL_RETURN(functionNamePtr, status)
+    #define DMX_PROBE_CALL_EXCEPTION(functionNamePtr, status, messagePtr)
+#endif
+
+/* Byte length of a string argument, 0 for other types */
+template<typename DmxType>
+inline size_t dmxInputSize(const void*) { return 0; }
+
+template<>
+inline size_t dmxInputSize<DmxString>(const void* bufferPtr) {
+    return (bufferPtr != NULL) ? static_cast<const DmxByteBuffer*>(bufferPtr)->m_size : 0;
+}
+
+/******************************************************************************/
+/* Custom function argument capture */
+
+struct DmxCaptureConfig
+{
+    std::string m_directory;                    // empty when capture is off
+    size_t m_sampleSize;
+};
+
+DMX_LIBRARY_FUNCTION DmxCaptureConfig dmxReadCaptureConfig() {
+    DmxCaptureConfig config;
+    const char* directoryPtr = getenv("DMX_CAPTURE_DIR");
+    const char* samplesPtr = getenv("DMX_CAPTURE_SAMPLES");
+    config.m_directory = (directoryPtr != NULL) ? directoryPtr : "";
+    config.m_sampleSize = (samplesPtr != NULL) ? strtoul(samplesPtr, NULL, 10) : DMX_CAPTURE_DEFAULT_SAMPLES;
+    if (config.m_sampleSize == 0) {
+        config.m_directory.clear();
+    }
+    return config;
+}
+
+/* Read once from the environment, the first time a function is called */
+DMX_LIBRARY_FUNCTION const DmxCaptureConfig& dmxCaptureConfig() {
+    static const DmxCaptureConfig s_captureConfig = dmxReadCaptureConfig();
+    return s_captureConfig;
+}
+
+DMX_LIBRARY_FUNCTION bool dmxCaptureIsEnabled() {
+    return !dmxCaptureConfig().m_directory.empty();
+}
+
+/* xorshift64, one generator per thread */
+DMX_LIBRARY_FUNCTION unsigned long long dmxCaptureRandom() {
+    static thread_local unsigned long long s_state = 0x9e3779b97f4a7c15ULL ^ reinterpret_cast<size_t>(&s_state);
+    s_state ^= s_state << 13;
+    s_state ^= s_state >> 7;
+    s_state ^= s_state << 17;
+    return s_state;
+}
+
+/* Encoded argument, see the capture file format; numeric types copy their value */
+template<typename DmxType>
+inline void dmxCaptureArgument(std::string& record, const void* bufferPtr) {
+    record += (bufferPtr == NULL) ? '\1' : '\0';
+    if (bufferPtr != NULL) {
+        record.append(static_cast<const char*>(bufferPtr), sizeof(typename DmxType::BufferType));
+    }
+}
+
+template<>
+inline void dmxCaptureArgument<DmxString>(std::string& record, const void* bufferPtr) {
+    record += (bufferPtr == NULL) ? '\1' : '\0';
+    if (bufferPtr != NULL) {
+        const DmxByteBuffer* stringPtr = static_cast<const DmxByteBuffer*>(bufferPtr);
+        unsigned long long length = stringPtr->m_size;
+        record.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        record.append(stringPtr->m_dataPtr, stringPtr->m_size);
+    }
+}
+
+template<>
+inline void dmxCaptureArgument<DmxDateTime>(std::string& record, const void* bufferPtr) {
+    record += (bufferPtr == NULL) ? '\1' : '\0';
+    if (bufferPtr != NULL) {
+        const DmxDateTimeBuffer* dateTimePtr = static_cast<const DmxDateTimeBuffer*>(bufferPtr);
+        const int fields[6] = { dateTimePtr->m_dateTime.tm_year, dateTimePtr->m_dateTime.tm_mon,
+                                dateTimePtr->m_dateTime.tm_mday, dateTimePtr->m_dateTime.tm_hour,
+                                dateTimePtr->m_dateTime.tm_min, dateTimePtr->m_dateTime.tm_sec };
+        record.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+        record.append(reinterpret_cast<const char*>(&dateTimePtr->m_fractionalSecond), sizeof(double));
+    }
+}
+
+/* Reservoir sample of the calls of one function (algorithm R), written out
+   when the library is unloaded */
+class DmxCaptureReservoir
+{
+public:
+    DmxCaptureReservoir(const char* functionNamePtr, const DmxTypeId* (*getArgTypesPtr)(size_t*))
+    : m_functionNamePtr(functionNamePtr),
+      m_seen(0)
+    {
+        size_t numArgs;
+        const DmxTypeId* typeIdsPtr = getArgTypesPtr(&numArgs);
+        m_typeIds.assign(typeIdsPtr, typeIdsPtr + numArgs);
+    }
+    ~DmxCaptureReservoir() { write(); }
+
+    /* slot for the current call, or (size_t)-1 if it is not sampled */
+    size_t sample()
+    {
+        unsigned long long seen = m_seen.fetch_add(1);
+        size_t sampleSize = dmxCaptureConfig().m_sampleSize;
+        if (seen < sampleSize) {
+            return static_cast<size_t>(seen);
+        }
+        unsigned long long slot = dmxCaptureRandom() % (seen + 1);
+        return (slot < sampleSize) ? static_cast<size_t>(slot) : static_cast<size_t>(-1);
+    }
+    void store(size_t slot, std::string& record)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (slot >= m_records.size()) {
+            m_records.resize(slot + 1);
+        }
+        m_records[slot].swap(record);
+    }
+    void write()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string path = dmxCaptureConfig().m_directory + "/" + m_functionNamePtr + DMX_CAPTURE_FILE_EXTENSION;
+        FILE* filePtr = fopen(path.c_str(), "wb");
+        if (filePtr == NULL) {
+            return;
+        }
+        unsigned nameLength = static_cast<unsigned>(strlen(m_functionNamePtr));
+        unsigned numArgs = static_cast<unsigned>(m_typeIds.size());
+        unsigned long long seen = m_seen.load();
+        unsigned numRecords = static_cast<unsigned>(m_records.size());
+        fwrite(DMX_CAPTURE_FILE_MAGIC, 1, strlen(DMX_CAPTURE_FILE_MAGIC), filePtr);
+        fwrite(&nameLength, sizeof(nameLength), 1, filePtr);
+        fwrite(m_functionNamePtr, 1, nameLength, filePtr);
+        fwrite(&numArgs, sizeof(numArgs), 1, filePtr);
+        for (size_t i = 0; i < m_typeIds.size(); i++) {
+            fputc(static_cast<unsigned char>(m_typeIds[i]), filePtr);
+        }
+        fwrite(&seen, sizeof(seen), 1, filePtr);
+        fwrite(&numRecords, sizeof(numRecords), 1, filePtr);
+        for (size_t i = 0; i < m_records.size(); i++) {
+            unsigned length = static_cast<unsigned>(m_records[i].size());
+            fwrite(&length, sizeof(length), 1, filePtr);
+            fwrite(m_records[i].data(), 1, length, filePtr);
+        }
+        fclose(filePtr);
+    }
+private:
+    DmxCaptureReservoir(const DmxCaptureReservoir&);
+    DmxCaptureReservoir& operator=(const DmxCaptureReservoir&);
+
+    const char* m_functionNamePtr;
+    std::vector<DmxTypeId> m_typeIds;
+    std::atomic<unsigned long long> m_seen;
+    std::mutex m_mutex;
+    std::vector<std::string> m_records;
+};
+
+/* Offer one call to the reservoir; the inputs are encoded only when sampled */
+template<typename... DmxTypes, typename... BufferPtrs>
+inline void dmxCaptureCall(DmxCaptureReservoir& reservoir, BufferPtrs... bufferPtrs) {
+    size_t slot = reservoir.sample();
+    if (slot == static_cast<size_t>(-1)) {
+        return;
+    }
+    std::string record;
+    int dmxExpand[] = { 0, (dmxCaptureArgument<DmxTypes>(record, bufferPtrs), 0)... };
+    (void)dmxExpand;
+    reservoir.store(slot, record);
+}
+
 /******************************************************************************/
 /* Custom function exception handling */
 
-extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBufferPtr, const char* exceptionMessagePtr) {
+extern "C" inline int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBufferPtr, const char* exceptionMessagePtr) {
     size_t length = strlen(exceptionMessagePtr);
     if (length > dmxExceptionBufferPtr->m_bufferSize) {
         length = dmxExceptionBufferPtr->m_bufferSize;
@@ -307,10 +1075,22 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
 #define DMX_CUSTOM_FUNCTION_TRY \
     try {
 
+/* Expects dmxCustomFunctionNamePtr in scope for the exception probe */
 #define DMX_CUSTOM_FUNCTION_CATCH \
+    } catch (const DmxCallTimedOut& e) { \
+        dmxTimedOutCalls().fetch_add(1, std::memory_order_relaxed); \
+        DMX_PROBE_CALL_EXCEPTION(dmxCustomFunctionNamePtr, DMX_CUSTOM_FUNCTION_TIMEOUT, e.what()); \
+        dmxReportCustomFunctionException(dmxExceptionBufferPtr, e.what()); \
+        return DMX_CUSTOM_FUNCTION_TIMEOUT; \
+    } catch (const DmxMemoryBudgetExceeded& e) { \
+        DMX_PROBE_CALL_EXCEPTION(dmxCustomFunctionNamePtr, DMX_CUSTOM_FUNCTION_FAILURE, e.what()); \
+        dmxReportCustomFunctionException(dmxExceptionBufferPtr, e.what()); \
+        return DMX_CUSTOM_FUNCTION_FAILURE; \
     } catch (const std::exception& e) { \
+        DMX_PROBE_CALL_EXCEPTION(dmxCustomFunctionNamePtr, DMX_CUSTOM_FUNCTION_EXCEPTION, e.what()); \
         return dmxReportCustomFunctionException(dmxExceptionBufferPtr, e.what()); \
     } catch (...) { \
+        DMX_PROBE_CALL_EXCEPTION(dmxCustomFunctionNamePtr, DMX_CUSTOM_FUNCTION_EXCEPTION, "Unknown exception"); \
         return dmxReportCustomFunctionException(dmxExceptionBufferPtr, "Unknown exception"); \
     }
 
@@ -326,11 +1106,22 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
     DMX_EXPORT_FUNCTION int functionName(DmxByteBuffer* dmxExceptionBufferPtr, \
                                          bool* dmxIsOutputNullPtr, \
                                          void* variableName1) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 0, \
+                                 0); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<>(dmxCaptureReservoir); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&); \
             int dmxCustomFunctionStatus = DMX_CONCAT(functionName, Impl)(dmxCustomFunctionOutput); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -348,13 +1139,24 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          bool* dmxIsOutputNullPtr, \
                                          void* variableName1, \
                                          void* variableName2) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2), \
+                                 1); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2>(dmxCaptureReservoir, variableName2); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&); \
             int dmxCustomFunctionStatus = DMX_CONCAT(functionName, Impl)(dmxCustomFunctionOutput, \
                                                                          variableName2); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -376,7 +1178,18 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName1, \
                                          void* variableName2, \
                                          void* variableName3) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3), \
+                                 2); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3>(dmxCaptureReservoir, variableName2, variableName3); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -385,6 +1198,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName2, \
                                                                          variableName3); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -410,7 +1224,19 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName2, \
                                          void* variableName3, \
                                          void* variableName4) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4), \
+                                 3); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4>(dmxCaptureReservoir, variableName2, variableName3, variableName4); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -421,6 +1247,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName3, \
                                                                          variableName4); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -450,7 +1277,20 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName3, \
                                          void* variableName4, \
                                          void* variableName5) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4) + \
+                                 dmxInputSize<DmxType5>(variableName5), \
+                                 4); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4, DmxType5>(dmxCaptureReservoir, variableName2, variableName3, variableName4, variableName5); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -463,6 +1303,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName4, \
                                                                          variableName5); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -496,7 +1337,21 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName4, \
                                          void* variableName5, \
                                          void* variableName6) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4) + \
+                                 dmxInputSize<DmxType5>(variableName5) + \
+                                 dmxInputSize<DmxType6>(variableName6), \
+                                 5); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4, DmxType5, DmxType6>(dmxCaptureReservoir, variableName2, variableName3, variableName4, variableName5, variableName6); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -511,6 +1366,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName5, \
                                                                          variableName6); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -548,7 +1404,22 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName5, \
                                          void* variableName6, \
                                          void* variableName7) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4) + \
+                                 dmxInputSize<DmxType5>(variableName5) + \
+                                 dmxInputSize<DmxType6>(variableName6) + \
+                                 dmxInputSize<DmxType7>(variableName7), \
+                                 6); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4, DmxType5, DmxType6, DmxType7>(dmxCaptureReservoir, variableName2, variableName3, variableName4, variableName5, variableName6, variableName7); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -565,6 +1436,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName6, \
                                                                          variableName7); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -606,7 +1478,23 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName6, \
                                          void* variableName7, \
                                          void* variableName8) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4) + \
+                                 dmxInputSize<DmxType5>(variableName5) + \
+                                 dmxInputSize<DmxType6>(variableName6) + \
+                                 dmxInputSize<DmxType7>(variableName7) + \
+                                 dmxInputSize<DmxType8>(variableName8), \
+                                 7); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4, DmxType5, DmxType6, DmxType7, DmxType8>(dmxCaptureReservoir, variableName2, variableName3, variableName4, variableName5, variableName6, variableName7, variableName8); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -625,6 +1513,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName7, \
                                                                          variableName8); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -670,7 +1559,24 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName7, \
                                          void* variableName8, \
                                          void* variableName9) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4) + \
+                                 dmxInputSize<DmxType5>(variableName5) + \
+                                 dmxInputSize<DmxType6>(variableName6) + \
+                                 dmxInputSize<DmxType7>(variableName7) + \
+                                 dmxInputSize<DmxType8>(variableName8) + \
+                                 dmxInputSize<DmxType9>(variableName9), \
+                                 8); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4, DmxType5, DmxType6, DmxType7, DmxType8, DmxType9>(dmxCaptureReservoir, variableName2, variableName3, variableName4, variableName5, variableName6, variableName7, variableName8, variableName9); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -691,6 +1597,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName8, \
                                                                          variableName9); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -740,7 +1647,25 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                          void* variableName8, \
                                          void* variableName9, \
                                          void* variableName10) { \
+        const char* const dmxCustomFunctionNamePtr = DMX_STRINGIFY(functionName); \
         DMX_CUSTOM_FUNCTION_TRY \
+            DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr); \
+            DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, \
+                                 dmxInputSize<DmxType2>(variableName2) + \
+                                 dmxInputSize<DmxType3>(variableName3) + \
+                                 dmxInputSize<DmxType4>(variableName4) + \
+                                 dmxInputSize<DmxType5>(variableName5) + \
+                                 dmxInputSize<DmxType6>(variableName6) + \
+                                 dmxInputSize<DmxType7>(variableName7) + \
+                                 dmxInputSize<DmxType8>(variableName8) + \
+                                 dmxInputSize<DmxType9>(variableName9) + \
+                                 dmxInputSize<DmxType10>(variableName10), \
+                                 9); \
+            if (dmxCaptureIsEnabled()) { \
+                static DmxCaptureReservoir dmxCaptureReservoir(dmxCustomFunctionNamePtr, \
+                    DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX, functionName)); \
+                dmxCaptureCall<DmxType2, DmxType3, DmxType4, DmxType5, DmxType6, DmxType7, DmxType8, DmxType9, DmxType10>(dmxCaptureReservoir, variableName2, variableName3, variableName4, variableName5, variableName6, variableName7, variableName8, variableName9, variableName10); \
+            } \
             DmxType1 dmxCustomFunctionOutput(variableName1, true); \
             int DMX_CONCAT(functionName, Impl)(DmxType1&, \
                                                const DmxType2&, \
@@ -763,6 +1688,7 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
                                                                          variableName9, \
                                                                          variableName10); \
             *dmxIsOutputNullPtr = dmxCustomFunctionOutput.isNull(); \
+            DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, dmxCustomFunctionStatus); \
             return dmxCustomFunctionStatus; \
         DMX_CUSTOM_FUNCTION_CATCH \
     } \
@@ -786,6 +1712,243 @@ extern "C" int dmxReportCustomFunctionException(DmxByteBuffer* dmxExceptionBuffe
         DMX_CONCAT(DECLARE_DMX_CUSTOM_FUNCTION_VA_ARGS_, DMX_NUM_VA_ARGS(__VA_ARGS__))(functionName, __VA_ARGS__) \
     )
 
+/******************************************************************************/
+/* Custom function prepare */
+
+/* State of the prepared call running on this thread, NULL otherwise */
+DMX_LIBRARY_FUNCTION const void*& dmxPreparedStatePtr() {
+    static thread_local const void* s_statePtr = NULL;
+    return s_statePtr;
+}
+
+/* Prepared state of the current call, NULL when called without a prepare */
+template<typename StateType>
+inline const StateType* dmxGetPreparedState() {
+    return static_cast<const StateType*>(dmxPreparedStatePtr());
+}
+
+/* Makes a state current for the duration of one call */
+class DmxPreparedScope
+{
+public:
+    explicit DmxPreparedScope(const void* statePtr)
+    : m_previousPtr(dmxPreparedStatePtr())
+    {
+        dmxPreparedStatePtr() = statePtr;
+    }
+    ~DmxPreparedScope() { dmxPreparedStatePtr() = m_previousPtr; }
+private:
+    DmxPreparedScope(const DmxPreparedScope&);
+    DmxPreparedScope& operator=(const DmxPreparedScope&);
+
+    const void* m_previousPtr;
+};
+
+/* 0, 1, ..., N - 1 as a template parameter pack */
+template<size_t... Indices> struct DmxIndices {};
+template<size_t N, size_t... Indices> struct DmxMakeIndices : DmxMakeIndices<N - 1, N - 1, Indices...> {};
+template<size_t... Indices> struct DmxMakeIndices<0, Indices...> { typedef DmxIndices<Indices...> Type; };
+
+template<typename... Args, size_t... Indices>
+inline int dmxInvokeEntry(int (*entryPtr)(DmxByteBuffer*, bool*, Args...), DmxByteBuffer* dmxExceptionBufferPtr,
+                          bool* isOutputNullPtr, void* const* argumentPtrs, DmxIndices<Indices...>) {
+    return entryPtr(dmxExceptionBufferPtr, isOutputNullPtr, argumentPtrs[Indices]...);
+}
+
+/* Run the generated entry point with the state current */
+template<typename... Args>
+inline int dmxCallPreparedEntry(int (*entryPtr)(DmxByteBuffer*, bool*, Args...), DmxByteBuffer* dmxExceptionBufferPtr,
+                                const void* statePtr, bool* isOutputNullPtr, void* const* argumentPtrs) {
+    DmxPreparedScope dmxPreparedScope(statePtr);
+    return dmxInvokeEntry(entryPtr, dmxExceptionBufferPtr, isOutputNullPtr, argumentPtrs,
+                          typename DmxMakeIndices<sizeof...(Args)>::Type());
+}
+
+/* Prepare phase of a declared custom function, for example
+       DMX_CUSTOM_FUNCTION_PREPARE(JsonExtract, JsonPathState, DMX_CONSTANT_ARGUMENT(2))
+   stateClass is built from the argument buffers, stateClass(void* const* argumentPtrs),
+   and read back in the function with dmxGetPreparedState<stateClass>() */
+
+#define DMX_CUSTOM_FUNCTION_PREPARE(functionName, stateClass, constantArguments) \
+    DMX_EXPORT_FUNCTION const DmxPrepareInfo* DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_PREPARE_INFO_PREFIX, functionName)() { \
+        static const DmxPrepareInfo dmxPrepareInfo = { constantArguments }; \
+        return &dmxPrepareInfo; \
+    } \
+    DMX_EXPORT_FUNCTION void* DMX_CONCAT(DMX_PREPARE_CUSTOM_FUNCTION_PREFIX, functionName)(DmxByteBuffer* dmxExceptionBufferPtr, \
+                                                                                   void* const* argumentPtrs) { \
+        try { \
+            DmxCallScope dmxCustomFunctionScope(DMX_STRINGIFY(functionName)); \
+            return dmxCreate<stateClass>(argumentPtrs); \
+        } catch (const std::exception& e) { \
+            dmxReportCustomFunctionException(dmxExceptionBufferPtr, e.what()); \
+        } catch (...) { \
+            dmxReportCustomFunctionException(dmxExceptionBufferPtr, "Unknown exception"); \
+        } \
+        return NULL; \
+    } \
+    DMX_EXPORT_FUNCTION int DMX_CONCAT(DMX_CALL_PREPARED_CUSTOM_FUNCTION_PREFIX, functionName)(DmxByteBuffer* dmxExceptionBufferPtr, \
+                                                                                       void* statePtr, \
+                                                                                       bool* isOutputNullPtr, \
+                                                                                       void* const* argumentPtrs) { \
+        return dmxCallPreparedEntry(functionName, dmxExceptionBufferPtr, statePtr, isOutputNullPtr, argumentPtrs); \
+    } \
+    DMX_EXPORT_FUNCTION void DMX_CONCAT(DMX_RELEASE_CUSTOM_FUNCTION_PREFIX, functionName)(void* statePtr) { \
+        dmxDestroy(static_cast<stateClass*>(statePtr)); \
+    }
+
+/******************************************************************************/
+/* Custom function streaming */
+
+#define DMX_STREAM_CHUNK_SIZE       (64 * 1024)
+
+/* Output of a stream, handed to the host in fixed size chunks */
+class DmxStreamWriter
+{
+public:
+    explicit DmxStreamWriter(const DmxStreamOutput& output)
+    : m_output(output),
+      m_buffer(DMX_STREAM_CHUNK_SIZE),
+      m_size(0)
+    {
+    }
+    /* room for at least minimumSize bytes at getData(), returns the room available */
+    size_t reserve(size_t minimumSize)
+    {
+        if (DMX_STREAM_CHUNK_SIZE - m_size < minimumSize) {
+            flush();
+        }
+        return DMX_STREAM_CHUNK_SIZE - m_size;
+    }
+    char* getData() { return &m_buffer[0] + m_size; }
+    void commit(size_t size) { m_size += size; }
+    void write(const char* dataPtr, size_t size)
+    {
+        while (size != 0) {
+            size_t count = reserve(1);
+            count = (count < size) ? count : size;
+            memcpy(getData(), dataPtr, count);
+            commit(count);
+            dataPtr += count;
+            size -= count;
+        }
+    }
+    void flush()
+    {
+        if (m_size != 0 && m_output.m_writePtr(m_output.m_contextPtr, &m_buffer[0], m_size) != 0) {
+            throw std::runtime_error("stream output rejected by the host");
+        }
+        m_size = 0;
+    }
+private:
+    DmxStreamWriter(const DmxStreamWriter&);
+    DmxStreamWriter& operator=(const DmxStreamWriter&);
+
+    DmxStreamOutput m_output;
+    std::vector<char, DmxAllocator<char> > m_buffer;
+    size_t m_size;
+};
+
+/* Streaming implementation of a function; state lives in the derived class */
+class DmxStreamFunction
+{
+public:
+    virtual ~DmxStreamFunction() {}
+    virtual void processChunk(const char* dataPtr, size_t size, DmxStreamWriter& writer) = 0;
+    virtual void finish(DmxStreamWriter&) {}
+};
+
+/* Releases a stream function created with dmxCreate as its own class */
+template<typename T>
+inline void dmxDestroyStreamFunction(DmxStreamFunction* functionPtr) {
+    dmxDestroy(static_cast<T*>(functionPtr));
+}
+
+/* One stream between begin and end, on the host memory callbacks */
+struct DmxStream
+{
+    DmxStream(DmxStreamFunction* functionPtr, void (*destroyFunctionPtr)(DmxStreamFunction*), const DmxStreamOutput& output)
+    : m_functionPtr(functionPtr),
+      m_destroyFunctionPtr(destroyFunctionPtr),
+      m_writer(output)
+    {
+    }
+    ~DmxStream() { m_destroyFunctionPtr(m_functionPtr); }
+
+    DmxStreamFunction* m_functionPtr;
+    void (*m_destroyFunctionPtr)(DmxStreamFunction*);
+    DmxStreamWriter m_writer;
+};
+
+DMX_LIBRARY_FUNCTION int dmxStreamChunk(DmxByteBuffer* dmxExceptionBufferPtr, const char* dmxCustomFunctionNamePtr,
+                                        void* streamPtr, const char* dataPtr, size_t size) {
+    DMX_CUSTOM_FUNCTION_TRY
+        DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr);
+        DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, size, 1);
+        DmxStream* dmxStreamPtr = static_cast<DmxStream*>(streamPtr);
+        dmxStreamPtr->m_functionPtr->processChunk(dataPtr, size, dmxStreamPtr->m_writer);
+        DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, DMX_CUSTOM_FUNCTION_SUCCESS);
+        return DMX_CUSTOM_FUNCTION_SUCCESS;
+    DMX_CUSTOM_FUNCTION_CATCH
+}
+
+DMX_LIBRARY_FUNCTION int dmxFinishStream(DmxByteBuffer* dmxExceptionBufferPtr, const char* dmxCustomFunctionNamePtr, DmxStream* streamPtr) {
+    DMX_CUSTOM_FUNCTION_TRY
+        DmxCallScope dmxCustomFunctionScope(dmxCustomFunctionNamePtr);
+        DMX_PROBE_CALL_ENTRY(dmxCustomFunctionNamePtr, 0, 0);
+        streamPtr->m_functionPtr->finish(streamPtr->m_writer);
+        streamPtr->m_writer.flush();
+        DMX_PROBE_CALL_RETURN(dmxCustomFunctionNamePtr, DMX_CUSTOM_FUNCTION_SUCCESS);
+        return DMX_CUSTOM_FUNCTION_SUCCESS;
+    DMX_CUSTOM_FUNCTION_CATCH
+}
+
+DMX_LIBRARY_FUNCTION int dmxEndStream(DmxByteBuffer* dmxExceptionBufferPtr, const char* functionNamePtr,
+                                      void* streamPtr, bool isAborted) {
+    DmxStream* dmxStreamPtr = static_cast<DmxStream*>(streamPtr);
+    int dmxCustomFunctionStatus = isAborted ? DMX_CUSTOM_FUNCTION_SUCCESS
+                                            : dmxFinishStream(dmxExceptionBufferPtr, functionNamePtr, dmxStreamPtr);
+    dmxDestroy(dmxStreamPtr);
+    return dmxCustomFunctionStatus;
+}
+
+/* Streaming variant of a declared custom function, for example
+       DMX_CUSTOM_STREAM_FUNCTION(TextToHex, TextToHexStream, DMX_STREAM_FORWARD) */
+
+#define DMX_CUSTOM_STREAM_FUNCTION(functionName, streamClass, direction) \
+    DMX_EXPORT_FUNCTION const DmxStreamInfo* DMX_CONCAT(DMX_GET_CUSTOM_FUNCTION_STREAM_INFO_PREFIX, functionName)() { \
+        static const DmxStreamInfo dmxStreamInfo = { direction, DMX_STREAM_CHUNK_SIZE }; \
+        return &dmxStreamInfo; \
+    } \
+    DMX_EXPORT_FUNCTION void* DMX_CONCAT(DMX_BEGIN_CUSTOM_FUNCTION_STREAM_PREFIX, functionName)(DmxByteBuffer* dmxExceptionBufferPtr, \
+                                                                                       const DmxStreamOutput* outputPtr) { \
+        try { \
+            DmxCallScope dmxCustomFunctionScope(DMX_STRINGIFY(functionName)); \
+            streamClass* dmxStreamFunctionPtr = dmxCreate<streamClass>(); \
+            try { \
+                return dmxCreate<DmxStream>(dmxStreamFunctionPtr, &dmxDestroyStreamFunction<streamClass>, *outputPtr); \
+            } catch (...) { \
+                dmxDestroy(dmxStreamFunctionPtr); \
+                throw; \
+            } \
+        } catch (const std::exception& e) { \
+            dmxReportCustomFunctionException(dmxExceptionBufferPtr, e.what()); \
+        } catch (...) { \
+            dmxReportCustomFunctionException(dmxExceptionBufferPtr, "Unknown exception"); \
+        } \
+        return NULL; \
+    } \
+    DMX_EXPORT_FUNCTION int DMX_CONCAT(DMX_CUSTOM_FUNCTION_STREAM_CHUNK_PREFIX, functionName)(DmxByteBuffer* dmxExceptionBufferPtr, \
+                                                                                     void* streamPtr, \
+                                                                                     const char* dataPtr, \
+                                                                                     size_t size) { \
+        return dmxStreamChunk(dmxExceptionBufferPtr, DMX_STRINGIFY(functionName), streamPtr, dataPtr, size); \
+    } \
+    DMX_EXPORT_FUNCTION int DMX_CONCAT(DMX_END_CUSTOM_FUNCTION_STREAM_PREFIX, functionName)(DmxByteBuffer* dmxExceptionBufferPtr, \
+                                                                                   void* streamPtr, \
+                                                                                   bool isAborted) { \
+        return dmxEndStream(dmxExceptionBufferPtr, DMX_STRINGIFY(functionName), streamPtr, isAborted); \
+    }
+
 /******************************************************************************/
 #endif /* #if !defined(__SSUPBUILD__) || defined(DMX_CUSTOM_FUNCTIONS_TEST) */
 
@@ -0,0 +1,49 @@
+#ifndef DMX_SIMD_H
+#define DMX_SIMD_H
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Helpers for SIMD fast paths in custom functions. Libraries are built for the
+ baseline instruction set; wider kernels are compiled per function with a
+ target attribute and selected at run time from the CPU features. Defining
+ DMX_SIMD_DISABLE builds the portable paths only.
+
+ *******************************************************************************/
+/******************************************************************************/
+
+#if !defined(DMX_SIMD_DISABLE) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+
+    #define DMX_SIMD_X86 1
+
+    #include <immintrin.h>
+    #include <cpuid.h>
+
+    #define DMX_TARGET_SSSE3    __attribute__((target("ssse3")))
+    #define DMX_TARGET_AVX2     __attribute__((target("avx2")))
+    #define DMX_TARGET_SHA      __attribute__((target("sha,sse4.1,ssse3")))
+
+    inline bool dmxCpuHasSsse3() { return __builtin_cpu_supports("ssse3"); }
+    inline bool dmxCpuHasAvx2() { return __builtin_cpu_supports("avx2"); }
+
+    /* SHA extensions: cpuid leaf 7 EBX bit 29, used together with SSE4.1 */
+    inline bool dmxCpuHasSha()
+    {
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        return (ebx & (1u << 29)) != 0 && __builtin_cpu_supports("sse4.1");
+    }
+
+#else
+
+    inline bool dmxCpuHasSsse3() { return false; }
+    inline bool dmxCpuHasAvx2() { return false; }
+    inline bool dmxCpuHasSha() { return false; }
+
+#endif
+
+#endif /* DMX_SIMD_H */
@@ -0,0 +1,143 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Generate the case mapping tables of StringNormalizeUtil.cpp from the simple
+ upper and lower case mappings (fields 12 and 13) of the Unicode Character
+ Database. Consecutive code points with the same mapping distance, or every
+ other code point for the alternating upper/lower blocks, share one range.
+
+ Usage: DmxCaseTable UnicodeData.txt > tables
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+
+/******************************************************************************/
+
+/* Code points first, first + step, ... last all map by delta */
+struct CaseRange {
+    uint32_t first;
+    uint32_t last;
+    uint32_t step;
+    int32_t delta;
+};
+
+typedef std::map<uint32_t, uint32_t> CaseMap;
+
+/****************************** MEMBER FUNCTION *******************************/
+static void readUnicodeData(std::istream& input, CaseMap& upper, CaseMap& lower) {
+//
+//Purpose
+//-------
+// collect the non identity simple mappings
+//
+    std::string line;
+    while (std::getline(input, line)) {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ';')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < 14) {
+            continue;
+        }
+        uint32_t codePoint = static_cast<uint32_t>(strtoul(fields[0].c_str(), NULL, 16));
+        if (!fields[12].empty()) {
+            upper[codePoint] = static_cast<uint32_t>(strtoul(fields[12].c_str(), NULL, 16));
+        }
+        if (!fields[13].empty()) {
+            lower[codePoint] = static_cast<uint32_t>(strtoul(fields[13].c_str(), NULL, 16));
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static std::vector<CaseRange> buildRanges(const CaseMap& mapping) {
+//
+//Purpose
+//-------
+// greedy ranges; an alternating range only skips code points without a
+// mapping so the ranges never overlap
+//
+    std::vector<CaseRange> ranges;
+    CaseMap::const_iterator it = mapping.begin();
+    while (it != mapping.end()) {
+        CaseRange range;
+        range.first = it->first;
+        range.last = it->first;
+        range.delta = static_cast<int32_t>(it->second) - static_cast<int32_t>(it->first);
+        range.step = 1;
+
+        CaseMap::const_iterator next = mapping.find(range.first + 1);
+        if (next == mapping.end() || static_cast<int32_t>(next->second) - static_cast<int32_t>(next->first) != range.delta) {
+            CaseMap::const_iterator other = mapping.find(range.first + 2);
+            if (next == mapping.end() && other != mapping.end()
+                && static_cast<int32_t>(other->second) - static_cast<int32_t>(other->first) == range.delta) {
+                range.step = 2;
+            }
+        }
+
+        for (;;) {
+            uint32_t codePoint = range.last + range.step;
+            CaseMap::const_iterator candidate = mapping.find(codePoint);
+            if (candidate == mapping.end() || static_cast<int32_t>(candidate->second) - static_cast<int32_t>(codePoint) != range.delta) {
+                break;
+            }
+            if (range.step == 2 && mapping.count(codePoint - 1) != 0) {
+                break;
+            }
+            range.last = codePoint;
+        }
+
+        ranges.push_back(range);
+        it = mapping.upper_bound(range.last);
+    }
+    return ranges;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void printRanges(const char* name, const std::vector<CaseRange>& ranges) {
+//
+//Purpose
+//-------
+// C array of { first, last, step, delta }
+//
+    printf("static const CaseRange %s[] = {\n", name);
+    for (size_t i = 0; i < ranges.size(); i++) {
+        printf("    { 0x%04X, 0x%04X, %u, %d },\n", ranges[i].first, ranges[i].last, ranges[i].step, ranges[i].delta);
+    }
+    printf("};\n");
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " UnicodeData.txt" << std::endl;
+        return 2;
+    }
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << argv[1] << ": cannot open" << std::endl;
+        return 1;
+    }
+
+    CaseMap upper;
+    CaseMap lower;
+    readUnicodeData(input, upper, lower);
+
+    printRanges("UPPER_CASE_RANGES", buildRanges(upper));
+    printf("\n");
+    printRanges("LOWER_CASE_RANGES", buildRanges(lower));
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Compare the throughput of the value codecs (LZ4 compression, hex) on
+ generated log-like column values of a given size.
+
+ Usage: DmxCodecBenchmark [value bytes] [values]
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include "CompressionUtil.h"
+#include "HexUtil.h"
+
+/******************************************************************************/
+
+/* Keeps results alive so the codecs are not optimized away */
+static size_t g_checksum = 0;
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue generateValue(size_t size, unsigned seed) {
+//
+//Purpose
+//-------
+// repetitive text resembling a large log or JSON column value
+//
+    static const char* const WORDS[] = { "GET", "POST", "/api/v1/orders", "/api/v1/customers", "status", "200", "404",
+                                         "\"region\":\"eu-west\"", "\"region\":\"us-east\"", "latency_ms", "user_agent" };
+    const size_t numWords = sizeof(WORDS) / sizeof(WORDS[0]);
+
+    std::ostringstream value;
+    srand(seed);
+    while (static_cast<size_t>(value.tellp()) < size) {
+        value << WORDS[rand() % numWords] << ' ' << rand() % 100000 << ' ';
+    }
+    std::string text = value.str();
+    return DmxStringValue(text.data(), (text.size() < size) ? text.size() : size);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+template <typename Codec>
+static void report(const char* name, const std::vector<DmxStringValue>& values, Codec codec) {
+//
+//Purpose
+//-------
+// run a codec over every value and print MB/s of input
+//
+    size_t bytes = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < values.size(); i++) {
+        g_checksum += codec(values[i]);
+        bytes += values[i].size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << bytes / seconds / 1e6 << " MB/s" << std::endl;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t compressValue(const DmxStringValue& value) {
+    std::vector<char> output(CompressionUtil::compressBound(value.size()));
+    return CompressionUtil::compress(value.data(), value.size(), &output[0]);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t decompressValue(const DmxStringValue& value) {
+    std::vector<char> output(CompressionUtil::decompressedSize(value.data(), value.size()) + 1);
+    CompressionUtil::decompress(value.data(), value.size(), &output[0]);
+    return output.size();
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t textToHex(const DmxStringValue& value) {
+    return HexUtil::textToHex(value).size();
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t hexToText(const DmxStringValue& value) {
+    return HexUtil::hexToText(value).size();
+}
+
+int main(int argc, char* argv[]) {
+
+    size_t valueSize = (argc > 1) ? strtoul(argv[1], NULL, 10) : 65536;
+    size_t numValues = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000;
+
+    std::vector<DmxStringValue> values;
+    std::vector<DmxStringValue> compressed;
+    std::vector<DmxStringValue> hex;
+    size_t compressedBytes = 0;
+    for (size_t i = 0; i < numValues; i++) {
+        values.push_back(generateValue(valueSize, static_cast<unsigned>(i)));
+        std::vector<char> output(CompressionUtil::compressBound(valueSize));
+        compressed.push_back(DmxStringValue(&output[0], CompressionUtil::compress(values[i].data(), values[i].size(), &output[0])));
+        compressedBytes += compressed[i].size();
+        hex.push_back(HexUtil::textToHex(values[i]));
+    }
+
+    std::cout << numValues << " values of " << valueSize << " bytes, compression ratio "
+              << static_cast<double>(valueSize * numValues) / compressedBytes << std::endl;
+    report("Compress", values, compressValue);
+    report("Decompress", compressed, decompressValue);
+    report("TextToHex", values, textToHex);
+    report("HexToText", hex, hexToText);
+    return g_checksum == 0;
+}
@@ -0,0 +1,220 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Test vectors of CryptoHashUtil.cpp: the FIPS 180 SHA-256 and SHA-1 examples
+ and the RFC 4231 HMAC-SHA-256 test cases, hashed at once and fed in pieces.
+ Built with the SHA extension kernels, used when the CPU has them, and with
+ DMX_SIMD_DISABLE for the portable kernels, which the load time known answer
+ check does not cover.
+
+ Usage: DmxHashVectors
+
+ *******************************************************************************/
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+#include "CryptoHashUtil.h"
+
+/******************************************************************************/
+
+/* FIPS 180 example message, repeated repeatCount times */
+struct DigestVector {
+    const char* message;
+    size_t repeatCount;
+    const char* sha256;
+    const char* sha1;
+};
+
+static const DigestVector DIGEST_VECTORS[] = {
+    { "", 1,
+      "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+      "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+    { "abc", 1,
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+      "a9993e364706816aba3e25717850c26c9cd0d89d" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+    { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+      "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+      "a49b2446a02c645bf419f995b67091253a04a259" },
+    { "a", 1000000,
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+      "34aa973cd4c4daa4f61eeb2bdbad27316534016f" }
+};
+
+/* RFC 4231 test case: key and data are byte fill patterns or text */
+struct HmacVector {
+    int testCase;
+    const char* key;
+    size_t keyLength;
+    const char* data;
+    size_t dataLength;
+    const char* mac;                // test case 5 gives the first 128 bits only
+};
+
+static const char KEY_0B[] = "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b";
+static const char KEY_0C[] = "\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c\x0c";
+static const char KEY_01_19[] = "\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19";
+
+/* Filled in by main: 0xaa keys of 20 and 131 bytes, 50 byte 0xdd and 0xcd data */
+static char g_keyAa[131];
+static char g_dataDd[50];
+static char g_dataCd[50];
+
+static const HmacVector HMAC_VECTORS[] = {
+    { 1, KEY_0B, 20, "Hi There", 8,
+      "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+    { 2, "Jefe", 4, "what do ya want for nothing?", 28,
+      "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+    { 3, g_keyAa, 20, g_dataDd, 50,
+      "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe" },
+    { 4, KEY_01_19, 25, g_dataCd, 50,
+      "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b" },
+    { 5, KEY_0C, 20, "Test With Truncation", 20,
+      "a3b6167473100ee06e0c796c2955552b" },
+    { 6, g_keyAa, 131, "Test Using Larger Than Block-Size Key - Hash Key First", 54,
+      "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" },
+    { 7, g_keyAa, 131, "This is a test using a larger than block-size key and a larger than block-size data. "
+                       "The key needs to be hashed before being used by the HMAC algorithm.", 152,
+      "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2" }
+};
+
+/* Piece sizes around the 64 byte block, cycled while feeding a message */
+static const size_t PIECE_SIZES[] = { 1, 63, 64, 65, 7, 128, 55, 56, 1000 };
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue toHex(const unsigned char* bytes, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    DmxStringValue hex;
+    for (size_t i = 0; i < size; i++) {
+        hex += digits[bytes[i] >> 4];
+        hex += digits[bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+template <typename Hash, size_t DigestLength>
+static DmxStringValue hashInPieces(const DmxStringValue& message) {
+//
+//Purpose
+//-------
+// digest of message fed through update in pieces of PIECE_SIZES
+//
+    Hash hash;
+    size_t piece = 0;
+    for (size_t offset = 0; offset < message.size(); piece++) {
+        size_t size = PIECE_SIZES[piece % (sizeof(PIECE_SIZES) / sizeof(PIECE_SIZES[0]))];
+        if (size > message.size() - offset) {
+            size = message.size() - offset;
+        }
+        hash.update(message.data() + offset, size);
+        offset += size;
+    }
+    unsigned char digest[DigestLength];
+    hash.final(digest);
+    return toHex(digest, DigestLength);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t check(const char* name, const DmxStringValue& actual, const char* expected) {
+//
+//Purpose
+//-------
+// 1 and the two digests if actual does not start with expected
+//
+    if (actual.compare(0, strlen(expected), expected) == 0) {
+        return 0;
+    }
+    std::cout << "  " << name << ": " << actual << " expected " << expected << std::endl;
+    return 1;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t checkDigests() {
+//
+//Purpose
+//-------
+// FIPS 180 examples, one shot and in pieces
+//
+    size_t failures = 0;
+    for (size_t i = 0; i < sizeof(DIGEST_VECTORS) / sizeof(DIGEST_VECTORS[0]); i++) {
+        const DigestVector& vector = DIGEST_VECTORS[i];
+        DmxStringValue message;
+        for (size_t j = 0; j < vector.repeatCount; j++) {
+            message += vector.message;
+        }
+        std::string name = "message " + std::to_string(i + 1);
+
+        failures += check((name + " SHA-256").c_str(), CryptoHashUtil::sha256(message), vector.sha256);
+        failures += check((name + " SHA-256 in pieces").c_str(), hashInPieces<Sha256, SHA256_DIGEST_LENGTH>(message), vector.sha256);
+        failures += check((name + " SHA-1").c_str(), CryptoHashUtil::sha1(message), vector.sha1);
+        failures += check((name + " SHA-1 in pieces").c_str(), hashInPieces<Sha1, SHA1_DIGEST_LENGTH>(message), vector.sha1);
+    }
+    return failures;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t checkPadding() {
+//
+//Purpose
+//-------
+// every length across the padding boundaries of the first blocks hashes
+// the same at once and in pieces
+//
+    size_t failures = 0;
+    DmxStringValue message;
+    for (size_t length = 0; length <= 3 * SHA_BLOCK_LENGTH; length++) {
+        std::string name = "length " + std::to_string(length);
+        failures += check((name + " SHA-256").c_str(), hashInPieces<Sha256, SHA256_DIGEST_LENGTH>(message),
+                          CryptoHashUtil::sha256(message).c_str());
+        failures += check((name + " SHA-1").c_str(), hashInPieces<Sha1, SHA1_DIGEST_LENGTH>(message),
+                          CryptoHashUtil::sha1(message).c_str());
+        message += static_cast<char>('a' + length % 26);
+    }
+    return failures;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static size_t checkHmacs() {
+//
+//Purpose
+//-------
+// RFC 4231 test cases through the per-thread key cache and through a key
+// schedule of their own
+//
+    size_t failures = 0;
+    for (size_t i = 0; i < sizeof(HMAC_VECTORS) / sizeof(HMAC_VECTORS[0]); i++) {
+        const HmacVector& vector = HMAC_VECTORS[i];
+        DmxStringValue key(vector.key, vector.keyLength);
+        DmxStringValue data(vector.data, vector.dataLength);
+        std::string name = "RFC 4231 test case " + std::to_string(vector.testCase);
+
+        failures += check(name.c_str(), CryptoHashUtil::hmacSha256(data, key), vector.mac);
+        failures += check((name + " key schedule").c_str(), CryptoHashUtil::hmacSha256(data, HmacSha256Key(key)), vector.mac);
+    }
+    return failures;
+}
+
+int main() {
+
+    memset(g_keyAa, 0xaa, sizeof(g_keyAa));
+    memset(g_dataDd, 0xdd, sizeof(g_dataDd));
+    memset(g_dataCd, 0xcd, sizeof(g_dataCd));
+
+    std::cout << "kernels: " << (CryptoHashUtil::isAccelerated() ? "SHA extensions" : "portable") << std::endl;
+
+    size_t digestFailures = checkDigests();
+    std::cout << "FIPS 180 SHA-256 and SHA-1: " << digestFailures << " failed" << std::endl;
+    size_t paddingFailures = checkPadding();
+    std::cout << "padding boundaries: " << paddingFailures << " failed" << std::endl;
+    size_t hmacFailures = checkHmacs();
+    std::cout << "RFC 4231 HMAC-SHA-256: " << hmacFailures << " failed" << std::endl;
+
+    return (digestFailures + paddingFailures + hmacFailures == 0) ? 0 : 1;
+}
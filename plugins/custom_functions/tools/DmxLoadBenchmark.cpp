@@ -0,0 +1,95 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Measure how long it takes to load a custom function library and resolve its
+ metadata, the way the host does for every short-lived job.
+
+ Usage: DmxLoadBenchmark library [iterations]
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <dlfcn.h>
+/* host side: only the ABI types, no plugin definitions */
+#define __SSUPBUILD__
+#include "dmx_custom_functions.h"
+
+#define LOAD_BENCHMARK_STRINGIFY_BASE(a)    #a
+#define LOAD_BENCHMARK_STRINGIFY(a)         LOAD_BENCHMARK_STRINGIFY_BASE(a)
+
+/******************************************************************************/
+
+typedef const char* const* (*DmxGetNamesFunction)(size_t*);
+typedef const DmxTypeId* (*DmxGetArgTypesFunction)(size_t*);
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " library [iterations]" << std::endl;
+        return 2;
+    }
+    const char* libraryPath = argv[1];
+    long iterations = 1000;
+    if (argc > 2) {
+        char* end;
+        iterations = strtol(argv[2], &end, 10);
+        if (*argv[2] == '\0' || *end != '\0' || iterations < 1) {
+            std::cerr << "iterations must be a positive number: " << argv[2] << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<double> latencies;
+    size_t numFunctions = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        void* library = dlopen(libraryPath, RTLD_NOW | RTLD_LOCAL);
+        if (library == NULL) {
+            std::cerr << dlerror() << std::endl;
+            return 1;
+        }
+        DmxGetNamesFunction getNames = reinterpret_cast<DmxGetNamesFunction>(
+            dlsym(library, LOAD_BENCHMARK_STRINGIFY(DMX_GET_CUSTOM_FUNCTION_NAMES)));
+        if (getNames == NULL) {
+            std::cerr << "missing " << LOAD_BENCHMARK_STRINGIFY(DMX_GET_CUSTOM_FUNCTION_NAMES) << std::endl;
+            return 1;
+        }
+
+        /* resolve every function and its argument types, as the host does */
+        const char* const* names = getNames(&numFunctions);
+        for (size_t j = 0; j < numFunctions; j++) {
+            std::string argTypesName = std::string(LOAD_BENCHMARK_STRINGIFY(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX)) + names[j];
+            DmxGetArgTypesFunction getArgTypes = reinterpret_cast<DmxGetArgTypesFunction>(dlsym(library, argTypesName.c_str()));
+            if (dlsym(library, names[j]) == NULL || getArgTypes == NULL) {
+                std::cerr << "missing entry points for " << names[j] << std::endl;
+                return 1;
+            }
+            size_t numArgs;
+            getArgTypes(&numArgs);
+        }
+
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        dlclose(library);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for (size_t i = 0; i < latencies.size(); i++) {
+        total += latencies[i];
+    }
+
+    std::cout << libraryPath << ": " << numFunctions << " functions, " << iterations << " loads" << std::endl
+              << "  mean " << total / latencies.size() << " us"
+              << ", median " << latencies[latencies.size() / 2] << " us"
+              << ", p99 " << latencies[latencies.size() * 99 / 100] << " us" << std::endl;
+    return 0;
+}
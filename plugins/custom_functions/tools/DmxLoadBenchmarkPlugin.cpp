@@ -0,0 +1,50 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ A plugin of 400 small functions for DmxLoadBenchmark, so load time and
+ exported symbols of a large library can be measured reproducibly:
+
+     DmxLoadBenchmark libDmxLoadBenchmarkPlugin.so 1000
+     nm -D --defined-only libDmxLoadBenchmarkPlugin.so | wc -l
+
+ The functions are generated by the preprocessor, LoadBenchmark000 to
+ LoadBenchmark399.
+
+ *******************************************************************************/
+#include <string>
+#include "dmx_custom_functions.h"
+
+/******************************************************************************/
+
+#define LOAD_BENCHMARK_FUNCTION(id) \
+    DMX_CUSTOM_FUNCTION(LoadBenchmark##id, DMX_STRING(text), DMX_STRING(input), DMX_INT(count)) { \
+        if (input.isNull() || count.isNull()) { \
+            text.setNull(); \
+        } \
+        else { \
+            text = input.substr(0, static_cast<size_t>(static_cast<long long>(count))); \
+        } \
+        return DMX_CUSTOM_FUNCTION_SUCCESS; \
+    }
+
+#define LOAD_BENCHMARK_TEN(prefix) \
+    LOAD_BENCHMARK_FUNCTION(prefix##0) LOAD_BENCHMARK_FUNCTION(prefix##1) \
+    LOAD_BENCHMARK_FUNCTION(prefix##2) LOAD_BENCHMARK_FUNCTION(prefix##3) \
+    LOAD_BENCHMARK_FUNCTION(prefix##4) LOAD_BENCHMARK_FUNCTION(prefix##5) \
+    LOAD_BENCHMARK_FUNCTION(prefix##6) LOAD_BENCHMARK_FUNCTION(prefix##7) \
+    LOAD_BENCHMARK_FUNCTION(prefix##8) LOAD_BENCHMARK_FUNCTION(prefix##9)
+
+#define LOAD_BENCHMARK_HUNDRED(prefix) \
+    LOAD_BENCHMARK_TEN(prefix##0) LOAD_BENCHMARK_TEN(prefix##1) \
+    LOAD_BENCHMARK_TEN(prefix##2) LOAD_BENCHMARK_TEN(prefix##3) \
+    LOAD_BENCHMARK_TEN(prefix##4) LOAD_BENCHMARK_TEN(prefix##5) \
+    LOAD_BENCHMARK_TEN(prefix##6) LOAD_BENCHMARK_TEN(prefix##7) \
+    LOAD_BENCHMARK_TEN(prefix##8) LOAD_BENCHMARK_TEN(prefix##9)
+
+LOAD_BENCHMARK_HUNDRED(0)
+LOAD_BENCHMARK_HUNDRED(1)
+LOAD_BENCHMARK_HUNDRED(2)
+LOAD_BENCHMARK_HUNDRED(3)
@@ -0,0 +1,366 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Replay the calls sampled with DMX_CAPTURE_DIR through the exported entry
+ point of a custom function library, the way the host calls it, and report
+ the throughput on production-shaped arguments.
+
+ Usage: DmxReplay library capture-file [iterations] [output bytes]
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <dlfcn.h>
+/* host side: only the ABI types, no plugin definitions */
+#define __SSUPBUILD__
+#include "dmx_custom_functions.h"
+
+#define REPLAY_STRINGIFY_BASE(a)    #a
+#define REPLAY_STRINGIFY(a)         REPLAY_STRINGIFY_BASE(a)
+
+/******************************************************************************/
+
+static const size_t EXCEPTION_BUFFER_SIZE = 1024;
+static const size_t MAX_ARGUMENTS = 10;
+
+typedef const DmxTypeId* (*DmxGetArgTypesFunction)(size_t*);
+typedef int (*DmxInitFunction)(const DmxMemoryCallbacks*);
+
+/* Contents of a capture file */
+struct CaptureFile {
+    std::string functionName;
+    std::vector<DmxTypeId> typeIds;         // output first
+    unsigned long long callsSeen;
+    std::vector<std::string> records;
+};
+
+/* Storage of one argument in host layout */
+struct ReplayArgument {
+    bool isNull;
+    union {
+        long long intValue;
+        unsigned long long unsignedValue;
+        double doubleValue;
+    };
+    DmxByteBuffer string;
+    DmxDateTimeBuffer dateTime;
+};
+
+/* One sampled call, arguments pointing into its record */
+struct ReplayCall {
+    std::vector<ReplayArgument> arguments;
+    std::vector<void*> argumentPtrs;        // output slot first, filled in per call
+    size_t inputBytes;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static void readBytes(std::istream& input, void* dataPtr, size_t size) {
+//
+//Purpose
+//-------
+// read exactly size bytes of the capture file
+//
+    if (!input.read(static_cast<char*>(dataPtr), size)) {
+        throw std::runtime_error("truncated capture file");
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static CaptureFile readCaptureFile(const char* path) {
+//
+//Purpose
+//-------
+// parse a capture file, see DMX_CAPTURE_FILE_MAGIC for the layout
+//
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error(std::string("cannot open ") + path);
+    }
+
+    CaptureFile capture;
+    std::string magic(strlen(DMX_CAPTURE_FILE_MAGIC), '\0');
+    readBytes(input, &magic[0], magic.size());
+    if (magic != DMX_CAPTURE_FILE_MAGIC) {
+        throw std::runtime_error(std::string(path) + " is not a capture file");
+    }
+
+    unsigned nameLength;
+    readBytes(input, &nameLength, sizeof(nameLength));
+    capture.functionName.resize(nameLength);
+    readBytes(input, &capture.functionName[0], nameLength);
+
+    unsigned numArgs;
+    readBytes(input, &numArgs, sizeof(numArgs));
+    if (numArgs == 0 || numArgs > MAX_ARGUMENTS) {
+        throw std::runtime_error("unsupported argument count in capture file");
+    }
+    for (unsigned i = 0; i < numArgs; i++) {
+        unsigned char typeId;
+        readBytes(input, &typeId, 1);
+        capture.typeIds.push_back(static_cast<DmxTypeId>(typeId));
+    }
+
+    unsigned numRecords;
+    readBytes(input, &capture.callsSeen, sizeof(capture.callsSeen));
+    readBytes(input, &numRecords, sizeof(numRecords));
+    capture.records.resize(numRecords);
+    for (unsigned i = 0; i < numRecords; i++) {
+        unsigned length;
+        readBytes(input, &length, sizeof(length));
+        capture.records[i].resize(length);
+        if (length != 0) {
+            readBytes(input, &capture.records[i][0], length);
+        }
+    }
+    return capture;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static ReplayCall decodeRecord(const std::string& record, const std::vector<DmxTypeId>& typeIds) {
+//
+//Purpose
+//-------
+// host buffers for the input arguments of a record; strings point into it
+//
+    ReplayCall call;
+    call.inputBytes = 0;
+    call.arguments.resize(typeIds.size() - 1);
+
+    size_t offset = 0;
+    for (size_t i = 1; i < typeIds.size(); i++) {
+        ReplayArgument& argument = call.arguments[i - 1];
+        if (offset >= record.size()) {
+            throw std::runtime_error("truncated capture record");
+        }
+        argument.isNull = (record[offset++] != 0);
+        if (argument.isNull) {
+            continue;
+        }
+
+        size_t size;
+        switch (typeIds[i]) {
+        case DMXTYPEID_STRING: {
+            unsigned long long length;
+            if (record.size() - offset < sizeof(length)) {
+                throw std::runtime_error("truncated capture record");
+            }
+            memcpy(&length, record.data() + offset, sizeof(length));
+            offset += sizeof(length);
+            if (record.size() - offset < length) {
+                throw std::runtime_error("truncated capture record");
+            }
+            argument.string.m_bufferSize = static_cast<size_t>(length);
+            argument.string.m_dataPtr = const_cast<char*>(record.data()) + offset;
+            argument.string.m_size = static_cast<size_t>(length);
+            call.inputBytes += static_cast<size_t>(length);
+            size = static_cast<size_t>(length);
+            break;
+        }
+        case DMXTYPEID_DATE_TIME: {
+            int fields[6];
+            size = sizeof(fields) + sizeof(double);
+            if (record.size() - offset < size) {
+                throw std::runtime_error("truncated capture record");
+            }
+            memcpy(fields, record.data() + offset, sizeof(fields));
+            memset(&argument.dateTime, 0, sizeof(argument.dateTime));
+            argument.dateTime.m_dateTime.tm_year = fields[0];
+            argument.dateTime.m_dateTime.tm_mon = fields[1];
+            argument.dateTime.m_dateTime.tm_mday = fields[2];
+            argument.dateTime.m_dateTime.tm_hour = fields[3];
+            argument.dateTime.m_dateTime.tm_min = fields[4];
+            argument.dateTime.m_dateTime.tm_sec = fields[5];
+            argument.dateTime.m_dateTime.tm_isdst = -1;
+            memcpy(&argument.dateTime.m_fractionalSecond, record.data() + offset + sizeof(fields), sizeof(double));
+            break;
+        }
+        default:
+            size = sizeof(argument.unsignedValue);
+            if (record.size() - offset < size) {
+                throw std::runtime_error("truncated capture record");
+            }
+            memcpy(&argument.unsignedValue, record.data() + offset, size);
+            break;
+        }
+        offset += size;
+    }
+
+    /* pointers once the argument storage no longer moves */
+    call.argumentPtrs.push_back(NULL);
+    for (size_t i = 1; i < typeIds.size(); i++) {
+        ReplayArgument& argument = call.arguments[i - 1];
+        void* argumentPtr = NULL;
+        if (!argument.isNull) {
+            switch (typeIds[i]) {
+            case DMXTYPEID_STRING:      argumentPtr = &argument.string; break;
+            case DMXTYPEID_DATE_TIME:   argumentPtr = &argument.dateTime; break;
+            default:                    argumentPtr = &argument.unsignedValue; break;
+            }
+        }
+        call.argumentPtrs.push_back(argumentPtr);
+    }
+    return call;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static int callEntryPoint(void* entryPtr, DmxByteBuffer* exceptionBufferPtr, bool* isOutputNullPtr,
+                          void* const* args, size_t numArgs) {
+//
+//Purpose
+//-------
+// call an exported custom function with numArgs argument buffers
+//
+    typedef DmxByteBuffer* E;
+    typedef bool* N;
+    typedef void* A;
+    switch (numArgs) {
+    case 1:  return reinterpret_cast<int (*)(E, N, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr, args[0]);
+    case 2:  return reinterpret_cast<int (*)(E, N, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr, args[0], args[1]);
+    case 3:  return reinterpret_cast<int (*)(E, N, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                        args[0], args[1], args[2]);
+    case 4:  return reinterpret_cast<int (*)(E, N, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                           args[0], args[1], args[2], args[3]);
+    case 5:  return reinterpret_cast<int (*)(E, N, A, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                              args[0], args[1], args[2], args[3], args[4]);
+    case 6:  return reinterpret_cast<int (*)(E, N, A, A, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                                 args[0], args[1], args[2], args[3], args[4],
+                                                                                 args[5]);
+    case 7:  return reinterpret_cast<int (*)(E, N, A, A, A, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                                    args[0], args[1], args[2], args[3], args[4],
+                                                                                    args[5], args[6]);
+    case 8:  return reinterpret_cast<int (*)(E, N, A, A, A, A, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                                       args[0], args[1], args[2], args[3], args[4],
+                                                                                       args[5], args[6], args[7]);
+    case 9:  return reinterpret_cast<int (*)(E, N, A, A, A, A, A, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                                          args[0], args[1], args[2], args[3], args[4],
+                                                                                          args[5], args[6], args[7], args[8]);
+    default: return reinterpret_cast<int (*)(E, N, A, A, A, A, A, A, A, A, A, A)>(entryPtr)(exceptionBufferPtr, isOutputNullPtr,
+                                                                                             args[0], args[1], args[2], args[3], args[4],
+                                                                                             args[5], args[6], args[7], args[8], args[9]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " library capture-file [iterations] [output bytes]" << std::endl;
+        return 2;
+    }
+    const char* libraryPath = argv[1];
+    long iterations = 100;
+    if (argc > 3) {
+        char* end;
+        iterations = strtol(argv[3], &end, 10);
+        if (*argv[3] == '\0' || *end != '\0' || iterations < 1) {
+            std::cerr << "iterations must be a positive number: " << argv[3] << std::endl;
+            return 2;
+        }
+    }
+    size_t outputCapacity = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1024 * 1024;
+
+    CaptureFile capture;
+    std::vector<ReplayCall> calls;
+    try {
+        capture = readCaptureFile(argv[2]);
+        for (size_t i = 0; i < capture.records.size(); i++) {
+            calls.push_back(decodeRecord(capture.records[i], capture.typeIds));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << argv[2] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    if (calls.empty()) {
+        std::cerr << argv[2] << ": no calls captured" << std::endl;
+        return 1;
+    }
+
+    /* the replayed library must not capture its own calls over the capture file */
+    unsetenv("DMX_CAPTURE_DIR");
+    void* library = dlopen(libraryPath, RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL) {
+        std::cerr << dlerror() << std::endl;
+        return 1;
+    }
+    DmxInitFunction init = reinterpret_cast<DmxInitFunction>(dlsym(library, REPLAY_STRINGIFY(DMX_INIT_CUSTOM_FUNCTION_LIBRARY)));
+    if (init != NULL && init(NULL) != DMX_CUSTOM_FUNCTION_SUCCESS) {
+        std::cerr << "library initialization failed" << std::endl;
+        return 1;
+    }
+
+    /* the entry point must still take the captured argument types */
+    std::string argTypesName = std::string(REPLAY_STRINGIFY(DMX_GET_CUSTOM_FUNCTION_ARG_TYPES_PREFIX)) + capture.functionName;
+    DmxGetArgTypesFunction getArgTypes = reinterpret_cast<DmxGetArgTypesFunction>(dlsym(library, argTypesName.c_str()));
+    void* entryPtr = dlsym(library, capture.functionName.c_str());
+    if (entryPtr == NULL || getArgTypes == NULL) {
+        std::cerr << "missing entry points for " << capture.functionName << std::endl;
+        return 1;
+    }
+    size_t numArgs;
+    const DmxTypeId* typeIds = getArgTypes(&numArgs);
+    if (numArgs != capture.typeIds.size() || !std::equal(capture.typeIds.begin(), capture.typeIds.end(), typeIds)) {
+        std::cerr << capture.functionName << ": argument types differ from the capture" << std::endl;
+        return 1;
+    }
+
+    /* output and exception buffers shared by every call */
+    std::vector<char> outputData(outputCapacity);
+    std::vector<char> exceptionData(EXCEPTION_BUFFER_SIZE);
+    DmxByteBuffer outputString = { outputCapacity, outputData.empty() ? NULL : &outputData[0], 0 };
+    DmxDateTimeBuffer outputDateTime;
+    unsigned long long outputNumber = 0;
+    DmxByteBuffer exceptionBuffer = { EXCEPTION_BUFFER_SIZE, &exceptionData[0], 0 };
+    void* outputPtr = (capture.typeIds[0] == DMXTYPEID_STRING) ? static_cast<void*>(&outputString)
+                    : (capture.typeIds[0] == DMXTYPEID_DATE_TIME) ? static_cast<void*>(&outputDateTime)
+                    : static_cast<void*>(&outputNumber);
+    for (size_t i = 0; i < calls.size(); i++) {
+        calls[i].argumentPtrs[0] = outputPtr;
+    }
+
+    size_t inputBytes = 0;
+    for (size_t i = 0; i < calls.size(); i++) {
+        inputBytes += calls[i].inputBytes;
+    }
+
+    /* a warm-up pass, which also counts the failing calls */
+    size_t failures = 0;
+    std::string firstFailure;
+    bool isOutputNull;
+    for (size_t i = 0; i < calls.size(); i++) {
+        int status = callEntryPoint(entryPtr, &exceptionBuffer, &isOutputNull, &calls[i].argumentPtrs[0], numArgs);
+        if (status != DMX_CUSTOM_FUNCTION_SUCCESS && failures++ == 0) {
+            firstFailure.assign(exceptionBuffer.m_dataPtr, exceptionBuffer.m_size);
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < iterations; pass++) {
+        for (size_t i = 0; i < calls.size(); i++) {
+            callEntryPoint(entryPtr, &exceptionBuffer, &isOutputNull, &calls[i].argumentPtrs[0], numArgs);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double totalCalls = static_cast<double>(calls.size()) * iterations;
+
+    std::cout << capture.functionName << ": " << calls.size() << " sampled calls of " << capture.callsSeen
+              << ", " << iterations << " passes" << std::endl
+              << "  " << totalCalls / seconds << " calls/s"
+              << ", " << seconds * 1e9 / totalCalls << " ns/call"
+              << ", " << static_cast<double>(inputBytes) * iterations / seconds / 1e6 << " MB/s of input" << std::endl;
+    if (failures != 0) {
+        std::cout << "  " << failures << " failed calls, first: " << firstFailure << std::endl;
+    }
+
+    dlclose(library);
+    return 0;
+}
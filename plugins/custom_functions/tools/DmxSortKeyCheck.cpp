@@ -0,0 +1,682 @@
+/*******************************************************************************
+
+ Copyright (c) 2017-present
+
+ Purpose
+ -------
+ Property check of the sort keys of SortKeyUtil.cpp on random pairs of
+ values: the memcmp order of two keys, shorter key first on a common prefix,
+ must be the order of the values. String keys must also equal a byte by byte
+ encoding of the documented format. Built with the AVX2 string encoder, used
+ when the CPU has it, and with DMX_SIMD_DISABLE for the portable encoder.
+
+ Usage: DmxSortKeyCheck [pairs]
+
+ *******************************************************************************/
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cfloat>
+#include <climits>
+#include <stdint.h>
+#include "dmx_simd.h"
+#include "SortKeyUtil.h"
+
+/******************************************************************************/
+
+/* Failures printed per property before only counting them */
+static const size_t MAX_REPORTED_FAILURES = 5;
+
+static uint64_t g_randomState = 0x243f6a8885a308d3ULL;
+
+/* Failures of the property being checked */
+struct CheckResult {
+    const char* name;
+    size_t pairs;
+    size_t failures;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static uint64_t nextRandom() {
+//
+//Purpose
+//-------
+// splitmix64, so a failure reproduces from the pair count alone
+//
+    uint64_t z = (g_randomState += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static int sign(long long value) {
+    return (value > 0) - (value < 0);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static int compareBytes(const DmxStringValue& first, const DmxStringValue& second) {
+//
+//Purpose
+//-------
+// memcmp order, the shorter first on a common prefix; -1, 0 or 1
+//
+    size_t common = (first.size() < second.size()) ? first.size() : second.size();
+    int result = (common != 0) ? memcmp(first.data(), second.data(), common) : 0;
+    if (result != 0) {
+        return sign(result);
+    }
+    return sign(static_cast<long long>(first.size()) - static_cast<long long>(second.size()));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void fail(CheckResult& result, const std::string& detail) {
+//
+//Purpose
+//-------
+// count a failed pair and print the first ones
+//
+    if (result.failures++ < MAX_REPORTED_FAILURES) {
+        std::cout << "  " << result.name << ": " << detail << std::endl;
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static std::string printable(const DmxStringValue& text) {
+//
+//Purpose
+//-------
+// text with bytes outside printable ASCII as \xHH
+//
+    static const char digits[] = "0123456789abcdef";
+    std::string output = "\"";
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c < 0x7f && c != '\\' && c != '"') {
+            output += static_cast<char>(c);
+        } else {
+            output += "\\x";
+            output += digits[c >> 4];
+            output += digits[c & 0x0f];
+        }
+    }
+    return output + "\"";
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue stringKey(const DmxStringValue& text, unsigned options, bool isExactCapacity) {
+//
+//Purpose
+//-------
+// key of text; an exact capacity below the worst case takes the buffered path
+//
+    size_t worstCase = 2 * text.size() + 2;
+    std::vector<char> output(worstCase);
+    size_t capacity = worstCase;
+    if (isExactCapacity) {
+        capacity = SortKeyUtil::stringKey(text, options, &output[0], worstCase);
+    }
+    size_t length = SortKeyUtil::stringKey(text, options, &output[0], capacity);
+    return DmxStringValue(&output[0], length);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static bool isAsciiSpace(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue foldAndTrim(const DmxStringValue& text, unsigned options) {
+//
+//Purpose
+//-------
+// the text a string key orders by
+//
+    size_t begin = 0;
+    size_t end = text.size();
+    if (options & SortKeyUtil::SORTKEY_TRIM) {
+        while (begin < end && isAsciiSpace(static_cast<unsigned char>(text[begin]))) {
+            begin++;
+        }
+        while (end > begin && isAsciiSpace(static_cast<unsigned char>(text[end - 1]))) {
+            end--;
+        }
+    }
+    DmxStringValue value = text.substr(begin, end - begin);
+    if (options & SortKeyUtil::SORTKEY_CASE_FOLD) {
+        for (size_t i = 0; i < value.size(); i++) {
+            if (value[i] >= 'A' && value[i] <= 'Z') {
+                value[i] += 'a' - 'A';
+            }
+        }
+    }
+    return value;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue referenceStringKey(const DmxStringValue& text, unsigned options) {
+//
+//Purpose
+//-------
+// the documented format one byte at a time: 0x00 as 0x00 0xFF, the
+// terminator 0x00 0x01, every byte inverted if descending
+//
+    DmxStringValue value = foldAndTrim(text, options);
+    char flip = (options & SortKeyUtil::SORTKEY_DESCENDING) ? static_cast<char>(0xFF) : 0;
+    DmxStringValue key;
+    for (size_t i = 0; i < value.size(); i++) {
+        key += static_cast<char>(value[i] ^ flip);
+        if (value[i] == 0) {
+            key += static_cast<char>(0xFF ^ flip);
+        }
+    }
+    key += static_cast<char>(0x00 ^ flip);
+    key += static_cast<char>(0x01 ^ flip);
+    return key;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue randomText() {
+//
+//Purpose
+//-------
+// short or long text over bytes at the edges of the encoding: 0x00, 0x01,
+// 0xFF, 0x80, ASCII whitespace and the neighbours of the upper case letters;
+// half of the texts have no 0x00 so 32 byte blocks reach the vector encoder
+//
+    static const char ALPHABET[] = { '\0', '\x01', '\xff', '\xfe', '\x80', ' ', '\t', '\r', '\x0e',
+                                     'A', 'Z', 'a', 'z', '@', '[', '`', '{', 'm', 'M', '0' };
+    const size_t alphabetSize = sizeof(ALPHABET);
+    size_t length = (nextRandom() % 3 == 0) ? nextRandom() % 100 : nextRandom() % 8;
+    bool hasZero = (nextRandom() & 1) != 0;
+
+    DmxStringValue text;
+    for (size_t i = 0; i < length; i++) {
+        text += ALPHABET[hasZero ? nextRandom() % alphabetSize : 1 + nextRandom() % (alphabetSize - 1)];
+    }
+    return text;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue relatedText(const DmxStringValue& text) {
+//
+//Purpose
+//-------
+// a text close to text: equal, an extension or a prefix of it, one byte
+// with its case bit flipped, or padded with whitespace
+//
+    DmxStringValue other = text;
+    switch (nextRandom() % 6) {
+    case 0:
+        break;
+    case 1:
+        other += randomText();
+        break;
+    case 2:
+        other.resize(other.size() - ((other.empty()) ? 0 : nextRandom() % (other.size() + 1)));
+        break;
+    case 3:
+        if (!other.empty()) {
+            other[nextRandom() % other.size()] ^= 0x20;
+        }
+        break;
+    case 4:
+        other = " \t" + other + "\r ";
+        break;
+    default:
+        other += '\0';
+        break;
+    }
+    return other;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkStrings(CheckResult& result) {
+//
+//Purpose
+//-------
+// every option combination: key order matches the folded and trimmed text
+// order, and the key bytes match the reference encoding
+//
+    for (size_t pair = 0; pair < result.pairs; pair++) {
+        DmxStringValue first = randomText();
+        DmxStringValue second = (nextRandom() & 1) ? relatedText(first) : randomText();
+        unsigned options = static_cast<unsigned>(nextRandom() % 8);
+        bool isExactCapacity = (nextRandom() & 1) != 0;
+
+        DmxStringValue firstKey = stringKey(first, options, isExactCapacity);
+        DmxStringValue secondKey = stringKey(second, options, isExactCapacity);
+        int expected = compareBytes(foldAndTrim(first, options), foldAndTrim(second, options));
+        if (options & SortKeyUtil::SORTKEY_DESCENDING) {
+            expected = -expected;
+        }
+
+        if (firstKey != referenceStringKey(first, options)) {
+            fail(result, "options " + std::to_string(options) + ", bad key of " + printable(first));
+        } else if (compareBytes(firstKey, secondKey) != expected) {
+            fail(result, "options " + std::to_string(options) + ", " + printable(first) + " vs " + printable(second));
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static double doubleFromBits(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static double randomDouble() {
+//
+//Purpose
+//-------
+// zeros, infinities, NaNs with any sign and payload, subnormals, the
+// extremes, small integers and random bit patterns
+//
+    static const uint64_t SPECIAL_BITS[] = {
+        0x0000000000000000ULL, 0x8000000000000000ULL,   // +0, -0
+        0x7FF0000000000000ULL, 0xFFF0000000000000ULL,   // +inf, -inf
+        0x7FF8000000000000ULL, 0xFFF8000000000000ULL,   // quiet NaNs
+        0x7FF0000000000001ULL, 0xFFFFFFFFFFFFFFFFULL,   // signaling NaN, NaN with a full payload
+        0x0000000000000001ULL, 0x8000000000000001ULL,   // smallest subnormals
+        0x000FFFFFFFFFFFFFULL, 0x800FFFFFFFFFFFFFULL,   // largest subnormals
+        0x0010000000000000ULL, 0x8010000000000000ULL,   // DBL_MIN
+        0x7FEFFFFFFFFFFFFFULL, 0xFFEFFFFFFFFFFFFFULL    // DBL_MAX
+    };
+    const size_t numSpecial = sizeof(SPECIAL_BITS) / sizeof(SPECIAL_BITS[0]);
+
+    switch (nextRandom() % 4) {
+    case 0:
+        return doubleFromBits(SPECIAL_BITS[nextRandom() % numSpecial]);
+    case 1:
+        return static_cast<double>(static_cast<long long>(nextRandom() % 7) - 3);
+    case 2:
+        /* subnormals */
+        return doubleFromBits((nextRandom() & 0x800FFFFFFFFFFFFFULL));
+    default:
+        return doubleFromBits(nextRandom());
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static int compareDoubles(double first, double second) {
+//
+//Purpose
+//-------
+// numeric order with -0 equal to 0 and every NaN equal, above infinity
+//
+    bool isFirstNan = first != first;
+    bool isSecondNan = second != second;
+    if (isFirstNan || isSecondNan) {
+        return static_cast<int>(isFirstNan) - static_cast<int>(isSecondNan);
+    }
+    return (first > second) - (first < second);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue doubleKey(double value, unsigned options) {
+    char key[NUMERIC_KEY_LENGTH];
+    return DmxStringValue(key, SortKeyUtil::doubleKey(value, options, key, sizeof(key)));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkDoubles(CheckResult& result) {
+//
+//Purpose
+//-------
+// double key order, ascending and descending
+//
+    for (size_t pair = 0; pair < result.pairs; pair++) {
+        double first = randomDouble();
+        double second = (nextRandom() % 4 == 0) ? -first : randomDouble();
+        unsigned options = (nextRandom() & 1) ? SortKeyUtil::SORTKEY_DESCENDING : 0;
+
+        int expected = compareDoubles(first, second);
+        if (options & SortKeyUtil::SORTKEY_DESCENDING) {
+            expected = -expected;
+        }
+        if (compareBytes(doubleKey(first, options), doubleKey(second, options)) != expected) {
+            char detail[96];
+            snprintf(detail, sizeof(detail), "options %u, %.17g vs %.17g", options, first, second);
+            fail(result, detail);
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static long long randomInt() {
+//
+//Purpose
+//-------
+// the extremes, values around 0 and random values
+//
+    static const long long SPECIAL_VALUES[] = { LLONG_MIN, LLONG_MIN + 1, -256, -1, 0, 1, 255, 256, LLONG_MAX - 1, LLONG_MAX };
+    const size_t numSpecial = sizeof(SPECIAL_VALUES) / sizeof(SPECIAL_VALUES[0]);
+
+    switch (nextRandom() % 3) {
+    case 0:
+        return SPECIAL_VALUES[nextRandom() % numSpecial];
+    case 1:
+        return static_cast<long long>(nextRandom() % 1000) - 500;
+    default:
+        return static_cast<long long>(nextRandom());
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue intKey(long long value, unsigned options) {
+    char key[NUMERIC_KEY_LENGTH];
+    return DmxStringValue(key, SortKeyUtil::intKey(value, options, key, sizeof(key)));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkInts(CheckResult& result) {
+//
+//Purpose
+//-------
+// integer key order, ascending and descending
+//
+    for (size_t pair = 0; pair < result.pairs; pair++) {
+        long long first = randomInt();
+        long long second = first;
+        if (nextRandom() % 4 != 0) {
+            second = randomInt();
+        } else {
+            /* a neighbour of first, none past the extremes */
+            unsigned step = static_cast<unsigned>(nextRandom() % 3);
+            if (step == 0 && first > LLONG_MIN) {
+                second = first - 1;
+            } else if (step == 2 && first < LLONG_MAX) {
+                second = first + 1;
+            }
+        }
+        unsigned options = (nextRandom() & 1) ? SortKeyUtil::SORTKEY_DESCENDING : 0;
+
+        int expected = (first > second) - (first < second);
+        if (options & SortKeyUtil::SORTKEY_DESCENDING) {
+            expected = -expected;
+        }
+        if (compareBytes(intKey(first, options), intKey(second, options)) != expected) {
+            fail(result, "options " + std::to_string(options) + ", " + std::to_string(first) + " vs " + std::to_string(second));
+        }
+    }
+}
+
+/* A date time and its fractional second */
+struct DateTimeValue {
+    struct tm dateTime;
+    double fractionalSecond;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static DateTimeValue randomDateTime() {
+//
+//Purpose
+//-------
+// every field within its range; years before 1900 make tm_year negative
+//
+    DateTimeValue value;
+    memset(&value.dateTime, 0, sizeof(value.dateTime));
+    value.dateTime.tm_year = static_cast<int>(nextRandom() % 6000) - 3000;
+    value.dateTime.tm_mon = static_cast<int>(nextRandom() % 12);
+    value.dateTime.tm_mday = 1 + static_cast<int>(nextRandom() % 31);
+    value.dateTime.tm_hour = static_cast<int>(nextRandom() % 24);
+    value.dateTime.tm_min = static_cast<int>(nextRandom() % 60);
+    value.dateTime.tm_sec = static_cast<int>(nextRandom() % 61);
+    value.fractionalSecond = (nextRandom() & 1) ? static_cast<double>(nextRandom() % 1000) / 1000.0
+                                                : doubleFromBits(nextRandom() % 0x3FF0000000000000ULL);
+    return value;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DateTimeValue relatedDateTime(const DateTimeValue& value) {
+//
+//Purpose
+//-------
+// the same date time with at most one field moved by one within its range
+//
+    DateTimeValue other = value;
+    int* fields[] = { &other.dateTime.tm_year, &other.dateTime.tm_mon, &other.dateTime.tm_mday,
+                      &other.dateTime.tm_hour, &other.dateTime.tm_min, &other.dateTime.tm_sec };
+    static const int MINIMUMS[] = { INT_MIN, 0, 1, 0, 0, 0 };
+    size_t field = nextRandom() % 7;
+    if (field == 6) {
+        other.fractionalSecond = static_cast<double>(nextRandom() % 1000) / 1000.0;
+    } else if (*fields[field] > MINIMUMS[field]) {
+        *fields[field] -= 1;
+    }
+    return other;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static int compareDateTimes(const DateTimeValue& first, const DateTimeValue& second) {
+//
+//Purpose
+//-------
+// field by field from the year down to the fractional second
+//
+    const int firstFields[] = { first.dateTime.tm_year, first.dateTime.tm_mon, first.dateTime.tm_mday,
+                                first.dateTime.tm_hour, first.dateTime.tm_min, first.dateTime.tm_sec };
+    const int secondFields[] = { second.dateTime.tm_year, second.dateTime.tm_mon, second.dateTime.tm_mday,
+                                 second.dateTime.tm_hour, second.dateTime.tm_min, second.dateTime.tm_sec };
+    for (size_t i = 0; i < 6; i++) {
+        if (firstFields[i] != secondFields[i]) {
+            return (firstFields[i] > secondFields[i]) ? 1 : -1;
+        }
+    }
+    return compareDoubles(first.fractionalSecond, second.fractionalSecond);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue dateTimeKey(const DateTimeValue& value, unsigned options) {
+    char key[DATE_TIME_KEY_LENGTH];
+    return DmxStringValue(key, SortKeyUtil::dateTimeKey(value.dateTime, value.fractionalSecond, options, key, sizeof(key)));
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkDateTimes(CheckResult& result) {
+//
+//Purpose
+//-------
+// date time key order, ascending and descending
+//
+    for (size_t pair = 0; pair < result.pairs; pair++) {
+        DateTimeValue first = randomDateTime();
+        DateTimeValue second = (nextRandom() & 1) ? relatedDateTime(first) : randomDateTime();
+        unsigned options = (nextRandom() & 1) ? SortKeyUtil::SORTKEY_DESCENDING : 0;
+
+        int expected = compareDateTimes(first, second);
+        if (options & SortKeyUtil::SORTKEY_DESCENDING) {
+            expected = -expected;
+        }
+        if (compareBytes(dateTimeKey(first, options), dateTimeKey(second, options)) != expected) {
+            char detail[128];
+            snprintf(detail, sizeof(detail), "options %u, year %d month %d vs year %d month %d", options,
+                     first.dateTime.tm_year, first.dateTime.tm_mon, second.dateTime.tm_year, second.dateTime.tm_mon);
+            fail(result, detail);
+        }
+    }
+}
+
+/* A row of the tuple (text, nullable integer descending, double) */
+struct TupleValue {
+    DmxStringValue text;
+    bool isNull;
+    long long number;
+    double measure;
+};
+
+/****************************** MEMBER FUNCTION *******************************/
+static TupleValue randomTuple() {
+    TupleValue value;
+    value.text = randomText();
+    value.isNull = nextRandom() % 4 == 0;
+    value.number = static_cast<long long>(nextRandom() % 5) - 2;
+    value.measure = randomDouble();
+    return value;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static int compareTuples(const TupleValue& first, const TupleValue& second, unsigned textOptions) {
+//
+//Purpose
+//-------
+// text first, then the integer descending with nulls first, then the double
+//
+    int result = compareBytes(foldAndTrim(first.text, textOptions), foldAndTrim(second.text, textOptions));
+    if (textOptions & SortKeyUtil::SORTKEY_DESCENDING) {
+        result = -result;
+    }
+    if (result == 0 && first.isNull != second.isNull) {
+        result = first.isNull ? -1 : 1;
+    }
+    if (result == 0 && !first.isNull) {
+        result = (first.number < second.number) - (first.number > second.number);
+    }
+    if (result == 0) {
+        result = compareDoubles(first.measure, second.measure);
+    }
+    return result;
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static DmxStringValue tupleKey(const TupleValue& value, unsigned textOptions) {
+//
+//Purpose
+//-------
+// concatenated field keys; the unused trailing fields are null
+//
+    DmxStringValue textKey = stringKey(value.text, textOptions, false);
+    DmxStringValue numberKey = intKey(value.number, SortKeyUtil::SORTKEY_DESCENDING);
+    DmxStringValue measureKey = doubleKey(value.measure, 0);
+    const DmxStringValue* keyPtrs[MAX_KEY_FIELDS] = { &textKey, value.isNull ? NULL : &numberKey, &measureKey };
+
+    std::vector<char> output(MAX_KEY_FIELDS + textKey.size() + numberKey.size() + measureKey.size());
+    size_t length = SortKeyUtil::concatKeys(keyPtrs, MAX_KEY_FIELDS, &output[0], output.size());
+    return DmxStringValue(&output[0], length);
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkConcatenation(CheckResult& result) {
+//
+//Purpose
+//-------
+// tuple key order: a field decides only when the fields before it are equal
+//
+    for (size_t pair = 0; pair < result.pairs; pair++) {
+        TupleValue first = randomTuple();
+        TupleValue second = randomTuple();
+        if (nextRandom() & 1) {
+            second.text = relatedText(first.text);
+            if (nextRandom() & 1) {
+                second.isNull = first.isNull;
+                second.number = first.number;
+            }
+        }
+        unsigned textOptions = static_cast<unsigned>(nextRandom() % 8);
+
+        if (compareBytes(tupleKey(first, textOptions), tupleKey(second, textOptions)) != compareTuples(first, second, textOptions)) {
+            fail(result, "options " + std::to_string(textOptions) + ", " + printable(first.text) + " vs " + printable(second.text));
+        }
+    }
+}
+
+/****************************** MEMBER FUNCTION *******************************/
+static void checkErrors(CheckResult& result) {
+//
+//Purpose
+//-------
+// a key that exactly fits is written, one byte less throws, and options a
+// key type does not have are rejected
+//
+    char output[DATE_TIME_KEY_LENGTH];
+    DmxStringValue text("a\0b", 3);
+    struct tm dateTime;
+    memset(&dateTime, 0, sizeof(dateTime));
+    dateTime.tm_mday = 1;
+
+    result.pairs = 0;
+    for (size_t capacity = 0; capacity <= 6; capacity++) {
+        result.pairs++;
+        try {
+            SortKeyUtil::stringKey(text, 0, output, capacity);
+            if (capacity < 6) {
+                fail(result, "string key written into " + std::to_string(capacity) + " bytes");
+            }
+        } catch (const std::runtime_error&) {
+            if (capacity == 6) {
+                fail(result, "string key of 6 bytes rejected");
+            }
+        }
+    }
+
+    result.pairs++;
+    try {
+        SortKeyUtil::intKey(1, SortKeyUtil::SORTKEY_CASE_FOLD, output, sizeof(output));
+        fail(result, "integer key accepted case folding");
+    } catch (const std::invalid_argument&) {
+    }
+
+    result.pairs++;
+    try {
+        SortKeyUtil::doubleKey(1.0, 0, output, NUMERIC_KEY_LENGTH - 1);
+        fail(result, "double key written into 7 bytes");
+    } catch (const std::runtime_error&) {
+    }
+
+    result.pairs++;
+    try {
+        SortKeyUtil::dateTimeKey(dateTime, 1.0, 0, output, sizeof(output));
+        fail(result, "date time key accepted a fractional second of 1");
+    } catch (const std::invalid_argument&) {
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    size_t pairs = 100000;
+    if (argc > 1) {
+        char* endPtr = NULL;
+        errno = 0;
+        long value = strtol(argv[1], &endPtr, 10);
+        if (errno != 0 || endPtr == argv[1] || *endPtr != '\0' || value <= 0) {
+            std::cerr << "Usage: " << argv[0] << " [pairs]" << std::endl;
+            return 2;
+        }
+        pairs = static_cast<size_t>(value);
+    }
+
+#if defined(DMX_SIMD_X86)
+    const char* encoder = dmxCpuHasAvx2() ? "AVX2" : "scalar, no AVX2 on this CPU";
+#else
+    const char* encoder = "scalar";
+#endif
+    std::cout << "string encoder: " << encoder << std::endl;
+
+    CheckResult results[] = {
+        { "strings", pairs, 0 },
+        { "doubles", pairs, 0 },
+        { "integers", pairs, 0 },
+        { "date times", pairs, 0 },
+        { "concatenation", pairs, 0 },
+        { "errors", 0, 0 }
+    };
+    checkStrings(results[0]);
+    checkDoubles(results[1]);
+    checkInts(results[2]);
+    checkDateTimes(results[3]);
+    checkConcatenation(results[4]);
+    checkErrors(results[5]);
+
+    size_t failures = 0;
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++) {
+        std::cout << results[i].name << ": " << results[i].pairs << " checked, " << results[i].failures << " failed" << std::endl;
+        failures += results[i].failures;
+    }
+    return (failures == 0) ? 0 : 1;
+}